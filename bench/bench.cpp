@@ -0,0 +1,617 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Micro-benchmarks for the log parsers, summarizer and ball kernels.
+//
+// usage: logstalgia-bench [--log FILE] [--filter NAME] [--min-time SECONDS]
+//                         [--baseline FILE] [--save-baseline FILE]
+//
+// Each benchmark is calibrated to run for at least --min-time seconds and
+// repeated; the median time per operation is reported. With --baseline the
+// change from a previously saved run is shown.
+
+#include "ncsa.h"
+#include "custom.h"
+#include "formatlog.h"
+#include "jsonlog.h"
+#include "logentry.h"
+#include "entryqueue.h"
+#include "compiledlog.h"
+#include "summarizer.h"
+#include "requestball.h"
+#include "settings.h"
+#include "profiler.h"
+
+#include "core/sdlapp.h"
+#include "core/display.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <algorithm>
+
+#define BENCH_REPEATS 5
+
+// deterministic corpus generation
+
+class BenchRandom {
+    unsigned int state;
+public:
+    BenchRandom(unsigned int seed = 12345) : state(seed) {}
+
+    unsigned int next() {
+        state = state * 1103515245 + 12345;
+        return (state >> 8) & 0xffffff;
+    }
+
+    int range(int n) { return next() % n; }
+};
+
+const char* bench_extensions[] = { ".html", ".css", ".js", ".jpg", ".png", ".gif", "", 0 };
+const char* bench_codes[]      = { "200", "200", "200", "200", "304", "301", "404", "500", 0 };
+
+int bench_count(const char** values) {
+    int n = 0;
+    while(values[n] != 0) n++;
+    return n;
+}
+
+std::string bench_hostname(BenchRandom& random) {
+    char buff[256];
+
+    switch(random.range(3)) {
+        case 0:
+            snprintf(buff, 256, "%d.%d.%d.%d", 1 + random.range(223), random.range(256), random.range(256), 1 + random.range(254));
+            break;
+        case 1:
+            snprintf(buff, 256, "dyn-%d.isp%d.example.com", random.range(10000), random.range(50));
+            break;
+        default:
+            snprintf(buff, 256, "2001:db8:%x:%x::%x", random.range(65536), random.range(65536), random.range(65536));
+            break;
+    }
+
+    return buff;
+}
+
+std::string bench_path(BenchRandom& random) {
+    char buff[256];
+
+    int ext = random.range(bench_count(bench_extensions));
+
+    snprintf(buff, 256, "/section%d/page%d/item%d%s", random.range(20), random.range(200), random.range(5000), bench_extensions[ext]);
+
+    return buff;
+}
+
+std::string bench_code(BenchRandom& random) {
+    return bench_codes[random.range(bench_count(bench_codes))];
+}
+
+std::vector<std::string> bench_ncsa_corpus(int count) {
+
+    BenchRandom random(1);
+    std::vector<std::string> lines;
+
+    time_t timestamp = 1262304000;
+
+    for(int i=0; i<count; i++) {
+        char date[64];
+        struct tm* tm = gmtime(&timestamp);
+        strftime(date, 64, "%d/%b/%Y:%H:%M:%S +0000", tm);
+
+        char buff[1024];
+        snprintf(buff, 1024, "%s - - [%s] \"GET %s HTTP/1.1\" %s %d \"-\" \"Mozilla/5.0 (X11; Linux x86_64)\"",
+                 bench_hostname(random).c_str(), date, bench_path(random).c_str(),
+                 bench_code(random).c_str(), random.range(100000));
+
+        lines.push_back(buff);
+
+        timestamp += random.range(2);
+    }
+
+    return lines;
+}
+
+std::vector<std::string> bench_custom_corpus(int count) {
+
+    BenchRandom random(2);
+    std::vector<std::string> lines;
+
+    long timestamp = 1262304000;
+
+    for(int i=0; i<count; i++) {
+        char buff[1024];
+        snprintf(buff, 1024, "%ld|%s|%s|%s|%d", timestamp, bench_hostname(random).c_str(),
+                 bench_path(random).c_str(), bench_code(random).c_str(), random.range(100000));
+
+        lines.push_back(buff);
+
+        timestamp += random.range(2);
+    }
+
+    return lines;
+}
+
+// nginx log_format escape=json style records
+std::vector<std::string> bench_json_corpus(int count) {
+
+    BenchRandom random(4);
+    std::vector<std::string> lines;
+
+    time_t timestamp = 1262304000;
+
+    for(int i=0; i<count; i++) {
+        char date[64];
+        struct tm* tm = gmtime(&timestamp);
+        strftime(date, 64, "%Y-%m-%dT%H:%M:%S+00:00", tm);
+
+        char buff[1024];
+        snprintf(buff, 1024, "{\"time_iso8601\":\"%s\",\"remote_addr\":\"%s\",\"remote_user\":\"-\","
+                 "\"request\":\"GET %s HTTP/1.1\",\"status\":\"%s\",\"body_bytes_sent\":\"%d\","
+                 "\"request_time\":\"0.%03d\",\"http_referer\":\"-\",\"http_user_agent\":\"Mozilla/5.0 (X11; Linux x86_64)\","
+                 "\"upstream_addr\":\"10.0.0.%d:8080\"}",
+                 date, bench_hostname(random).c_str(), bench_path(random).c_str(),
+                 bench_code(random).c_str(), random.range(100000), random.range(1000), random.range(8));
+
+        lines.push_back(buff);
+
+        timestamp += random.range(2);
+    }
+
+    return lines;
+}
+
+std::vector<std::string> bench_read_log(const std::string& path) {
+
+    std::vector<std::string> lines;
+
+    std::ifstream in(path.c_str());
+    std::string line;
+
+    while(std::getline(in, line)) {
+        if(!line.empty()) lines.push_back(line);
+    }
+
+    return lines;
+}
+
+// harness
+
+class Benchmark {
+public:
+    std::string name;
+
+    Benchmark(const std::string& name) : name(name) {}
+    virtual ~Benchmark() {}
+
+    // run the operation 'iterations' times
+    virtual void run(int iterations) = 0;
+};
+
+double bench_seconds(Uint64 ticks) {
+    return ticks / (double) profiler_ticks_per_second();
+}
+
+// returns median nanoseconds per operation
+double bench_measure(Benchmark* benchmark, double min_time) {
+
+    // calibrate
+    int iterations = 1;
+
+    while(true) {
+        Uint64 start = profiler_ticks();
+        benchmark->run(iterations);
+        double elapsed = bench_seconds(profiler_ticks() - start);
+
+        if(elapsed >= min_time / BENCH_REPEATS || iterations >= (1 << 30)) break;
+
+        double scale = (elapsed > 0.0) ? (min_time / BENCH_REPEATS) / elapsed * 1.2 : 10.0;
+        iterations = (int) std::min(1073741824.0, std::max(iterations * 2.0, iterations * std::min(scale, 100.0)));
+    }
+
+    std::vector<double> samples;
+
+    for(int i=0; i<BENCH_REPEATS; i++) {
+        Uint64 start = profiler_ticks();
+        benchmark->run(iterations);
+        samples.push_back(bench_seconds(profiler_ticks() - start) * 1e9 / iterations);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    return samples[BENCH_REPEATS/2];
+}
+
+// benchmarks
+
+class ParseBenchmark : public Benchmark {
+    AccessLog* accesslog;
+    std::vector<std::string> lines;
+    size_t index;
+public:
+    ParseBenchmark(const std::string& name, AccessLog* accesslog, const std::vector<std::string>& lines)
+        : Benchmark(name), accesslog(accesslog), lines(lines), index(0) {}
+
+    ~ParseBenchmark() { delete accesslog; }
+
+    void run(int iterations) {
+        for(int i=0; i<iterations; i++) {
+            LogEntry entry;
+            accesslog->parseLine(lines[index], entry);
+            index = (index + 1) % lines.size();
+        }
+    }
+};
+
+// entries queued by readLog() and spawned a second at a time by logic()
+class EntryQueueBenchmark : public Benchmark {
+    EntryQueue queue;
+    std::vector<LogEntry> entries;
+    size_t index;
+    long pushed;
+public:
+    EntryQueueBenchmark(const std::vector<std::string>& lines)
+        : Benchmark("EntryQueue::push/pop"), index(0), pushed(0) {
+        NCSALog log;
+
+        for(std::string line : lines) {
+            LogEntry entry;
+            if(log.parseLine(line, entry)) entries.push_back(entry);
+        }
+    }
+
+    void run(int iterations) {
+        for(int i=0; i<iterations; i++) {
+            LogEntry& entry = entries[index];
+            entry.timestamp = pushed++ / 100;
+
+            queue.push(entry);
+            index = (index + 1) % entries.size();
+
+            if(queue.size() >= 200) queue.pop(queue.countUntil(queue.front().timestamp));
+        }
+    }
+};
+
+// entries replayed from a --compile-log file, compared to parsing the text
+class CompiledLogBenchmark : public Benchmark {
+    std::string filename;
+    CompiledLog* log;
+    CompiledAccessLog* accesslog;
+public:
+    CompiledLogBenchmark(const std::vector<std::string>& lines)
+        : Benchmark("CompiledLog::readEntry (generated)"), filename("bench-compiled.lsb") {
+        NCSALog parser;
+        LogCompiler compiler(filename);
+
+        for(std::string line : lines) {
+            LogEntry entry;
+            if(parser.parseLine(line, entry)) compiler.add(entry);
+        }
+
+        compiler.finish();
+
+        log       = new CompiledLog(filename);
+        accesslog = new CompiledAccessLog(log);
+    }
+
+    ~CompiledLogBenchmark() {
+        delete accesslog;
+        delete log;
+        remove(filename.c_str());
+    }
+
+    void run(int iterations) {
+        std::string line;
+
+        for(int i=0; i<iterations; i++) {
+            if(!log->getNextLine(line)) {
+                log->seekTo(0.0f);
+                log->getNextLine(line);
+            }
+
+            LogEntry entry;
+            accesslog->parseLine(line, entry);
+        }
+    }
+};
+
+// masks hostnames directly, without the rest of LogEntry::validate()
+class MaskHostnameBenchmark : public Benchmark {
+    std::vector<std::string> hostnames;
+    size_t index;
+    LogEntry entry;
+public:
+    MaskHostnameBenchmark(const std::vector<std::string>& hostnames)
+        : Benchmark("LogEntry::maskHostname"), hostnames(hostnames), index(0) {}
+
+    void run(int iterations) {
+        size_t total = 0;
+
+        for(int i=0; i<iterations; i++) {
+            total += entry.maskHostname(hostnames[index]).size();
+            index = (index + 1) % hostnames.size();
+        }
+
+        if(total == 0) printf(" ");
+    }
+};
+
+// adds then removes each word, so the tree returns to its initial state
+class SummNodeBenchmark : public Benchmark {
+    SummNode root;
+    std::vector<std::string> words;
+    size_t index;
+public:
+    SummNodeBenchmark(const std::vector<std::string>& words)
+        : Benchmark("SummNode::addWord+removeWord"), words(words), index(0) {
+
+        // half the words are resident
+        for(size_t i=0; i<words.size(); i+=2) {
+            root.addWord(words[i], 0);
+        }
+    }
+
+    void run(int iterations) {
+        for(int i=0; i<iterations; i++) {
+            root.addWord(words[index], 0);
+            root.removeWord(words[index], 0);
+            index = (index + 1) % words.size();
+        }
+    }
+};
+
+class SummarizeBenchmark : public Benchmark {
+    Summarizer* summarizer;
+public:
+    SummarizeBenchmark(FXFont font, const std::vector<std::string>& words)
+        : Benchmark("Summarizer::summarize") {
+
+        summarizer = new Summarizer(font, 100, 2.0f);
+        summarizer->setSize(2, 40, 0);
+
+        for(const std::string& word : words) {
+            summarizer->addString(word);
+        }
+    }
+
+    ~SummarizeBenchmark() { delete summarizer; }
+
+    Summarizer* getSummarizer() { return summarizer; }
+
+    void run(int iterations) {
+        for(int i=0; i<iterations; i++) {
+            summarizer->summarize();
+        }
+    }
+};
+
+class BestMatchBenchmark : public Benchmark {
+    Summarizer* summarizer;
+    std::vector<std::string> words;
+    size_t index;
+public:
+    BestMatchBenchmark(Summarizer* summarizer, const std::vector<std::string>& words)
+        : Benchmark("Summarizer::getBestMatchIndex"), summarizer(summarizer), words(words), index(0) {
+        summarizer->summarize();
+    }
+
+    void run(int iterations) {
+        int total = 0;
+
+        for(int i=0; i<iterations; i++) {
+            total += summarizer->getBestMatchIndex(words[index]);
+            index = (index + 1) % words.size();
+        }
+
+        if(total == -1) printf(" ");
+    }
+};
+
+class BenchBall : public RequestBall {
+public:
+    BenchBall(LogEntry* le, const vec2& pos, const vec2& dest)
+        : RequestBall(le, vec3(1.0f), pos, dest) {}
+
+    using RequestBall::animate;
+};
+
+// animates a screen full of balls, replacing each when it finishes
+class AnimateBenchmark : public Benchmark {
+    std::vector<BenchBall*> balls;
+    BenchRandom random;
+
+    BenchBall* createBall() {
+        LogEntry* le = new LogEntry();
+        le->response_size = 1 + random.range(100000);
+        le->successful    = random.range(10) != 0;
+
+        vec2 pos(-10.0f, (float) random.range(display.height));
+        vec2 dest(display.width * 0.67f, (float) random.range(display.height));
+
+        return new BenchBall(le, pos, dest);
+    }
+public:
+    AnimateBenchmark() : Benchmark("RequestBall::animate") {
+        for(int i=0; i<1000; i++) balls.push_back(createBall());
+    }
+
+    ~AnimateBenchmark() {
+        for(BenchBall* ball : balls) delete ball;
+    }
+
+    void run(int iterations) {
+        for(int i=0; i<iterations; i++) {
+            BenchBall*& ball = balls[i % balls.size()];
+
+            ball->animate(1.0f / 60.0f);
+
+            if(ball->isFinished()) {
+                delete ball;
+                ball = createBall();
+            }
+        }
+    }
+};
+
+// baselines
+
+std::map<std::string, double> bench_load_baseline(const std::string& path) {
+
+    std::map<std::string, double> baseline;
+
+    std::ifstream in(path.c_str());
+    std::string line;
+
+    while(std::getline(in, line)) {
+        size_t tab = line.rfind('\t');
+        if(line.empty() || line[0] == '#' || tab == std::string::npos) continue;
+
+        baseline[line.substr(0, tab)] = atof(line.substr(tab+1).c_str());
+    }
+
+    return baseline;
+}
+
+void bench_usage() {
+    printf("usage: logstalgia-bench [--log FILE] [--filter NAME] [--min-time SECONDS]\n");
+    printf("                        [--baseline FILE] [--save-baseline FILE]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+    std::string log_path = "data/example.log";
+    std::string filter;
+    std::string baseline_path;
+    std::string save_path;
+    double min_time = 1.0;
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+
+        if(i+1 >= argc) bench_usage();
+
+        if(arg == "--log")                log_path      = argv[++i];
+        else if(arg == "--filter")        filter        = argv[++i];
+        else if(arg == "--baseline")      baseline_path = argv[++i];
+        else if(arg == "--save-baseline") save_path     = argv[++i];
+        else if(arg == "--min-time")      min_time      = atof(argv[++i]);
+        else bench_usage();
+    }
+
+    SDLAppInit("Logstalgia", "logstalgia");
+
+    display.width  = 1024;
+    display.height = 768;
+
+    std::vector<std::string> example = bench_read_log(log_path);
+
+    if(example.empty()) {
+        fprintf(stderr, "could not read %s\n", log_path.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> ncsa   = bench_ncsa_corpus(10000);
+    std::vector<std::string> custom = bench_custom_corpus(10000);
+    std::vector<std::string> json   = bench_json_corpus(10000);
+
+    BenchRandom random(3);
+
+    std::vector<std::string> hostnames;
+    std::vector<std::string> paths;
+
+    for(int i=0; i<10000; i++) {
+        hostnames.push_back(bench_hostname(random));
+        paths.push_back(bench_path(random));
+    }
+
+    //there is no GL context to create fonts with, the summarizers use the
+    //font size for their layout instead
+    settings.no_display = true;
+
+    FXFont font;
+
+    SummarizeBenchmark* summarize = new SummarizeBenchmark(font, paths);
+
+    std::vector<Benchmark*> benchmarks;
+    benchmarks.push_back(new ParseBenchmark("NCSALog::parseLine (example.log)", new NCSALog(), example));
+    benchmarks.push_back(new ParseBenchmark("NCSALog::parseLine (generated)", new NCSALog(), ncsa));
+    benchmarks.push_back(new ParseBenchmark("FormatLog::parseLine (generated, combined)", new FormatLog("combined"), ncsa));
+    benchmarks.push_back(new ParseBenchmark("CustomAccessLog::parseLine (generated)", new CustomAccessLog(), custom));
+    benchmarks.push_back(new ParseBenchmark("JSONLog::parseLine (generated)", new JSONLog(), json));
+    benchmarks.push_back(new CompiledLogBenchmark(ncsa));
+    benchmarks.push_back(new EntryQueueBenchmark(ncsa));
+    benchmarks.push_back(new MaskHostnameBenchmark(hostnames));
+    benchmarks.push_back(new SummNodeBenchmark(paths));
+    benchmarks.push_back(summarize);
+    benchmarks.push_back(new BestMatchBenchmark(summarize->getSummarizer(), paths));
+    benchmarks.push_back(new AnimateBenchmark());
+
+    std::map<std::string, double> baseline;
+    if(!baseline_path.empty()) baseline = bench_load_baseline(baseline_path);
+
+    FILE* save = 0;
+
+    if(!save_path.empty()) {
+        save = fopen(save_path.c_str(), "w");
+
+        if(save == 0) {
+            fprintf(stderr, "could not write to %s\n", save_path.c_str());
+            return 1;
+        }
+
+        fprintf(save, "# logstalgia-bench baseline (name<TAB>ns/op)\n");
+    }
+
+    printf("%-42s %12s %12s %8s\n", "benchmark", "ns/op", "baseline", "change");
+
+    for(Benchmark* benchmark : benchmarks) {
+
+        if(!filter.empty() && benchmark->name.find(filter) == std::string::npos) continue;
+
+        double ns = bench_measure(benchmark, min_time);
+
+        auto it = baseline.find(benchmark->name);
+
+        if(it != baseline.end() && it->second > 0.0) {
+            printf("%-42s %12.1f %12.1f %+7.1f%%\n", benchmark->name.c_str(), ns, it->second, (ns / it->second - 1.0) * 100.0);
+        } else {
+            printf("%-42s %12.1f %12s %8s\n", benchmark->name.c_str(), ns, "-", "-");
+        }
+
+        fflush(stdout);
+
+        if(save != 0) fprintf(save, "%s\t%.1f\n", benchmark->name.c_str(), ns);
+    }
+
+    if(save != 0) fclose(save);
+
+    // BestMatchBenchmark uses the summarizer owned by SummarizeBenchmark
+    for(auto it = benchmarks.rbegin(); it != benchmarks.rend(); it++) {
+        delete *it;
+    }
+
+    return 0;
+}
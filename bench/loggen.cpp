@@ -0,0 +1,542 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Synthetic access log generator for load and scaling tests.
+//
+// Writes NCSA combined, custom (pipe separated) or JSON log lines to stdout, with
+// URLs and hosts drawn from Zipf distributions, optional periodic bursts and
+// a configurable ratio of error responses.
+//
+// By default timestamps start at --start and lines are written as fast as
+// possible. With --stream lines are written in real time at the requested
+// rate with the current time, eg to test --sync:
+//
+//   logstalgia-loggen --stream --rate 100000 --urls 1000000 | logstalgia --sync
+//
+// With --syslog lines are sent as syslog messages to a localhost port
+// instead, eg to test --listen:
+//
+//   logstalgia --listen 5140 --sync &
+//   logstalgia-loggen --stream --syslog udp:5140
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#define LOGGEN_FORMAT_NCSA   0
+#define LOGGEN_FORMAT_CUSTOM 1
+#define LOGGEN_FORMAT_JSON   2
+
+struct LogGenSettings {
+    int    format;
+    double rate;
+    double duration;
+    long   count;
+    int    urls;
+    int    hosts;
+    double url_skew;
+    double host_skew;
+    int    vhosts;
+    int    pids;
+    double burst_period;
+    double burst_length;
+    double burst_factor;
+    double error_ratio;
+    bool   stream;
+    long   start;
+    unsigned int seed;
+    std::string syslog;
+    bool   rfc5424;
+
+    LogGenSettings() {
+        format       = LOGGEN_FORMAT_NCSA;
+        rate         = 100.0;
+        duration     = 60.0;
+        count        = 0;
+        urls         = 10000;
+        hosts        = 1000;
+        url_skew     = 1.0;
+        host_skew    = 1.0;
+        vhosts       = 0;
+        pids         = 0;
+        burst_period = 0.0;
+        burst_length = 0.0;
+        burst_factor = 10.0;
+        error_ratio  = 0.02;
+        stream       = false;
+        start        = 1262304000;
+        seed         = 1;
+        rfc5424      = false;
+    }
+};
+
+// xorshift64*
+class LogGenRandom {
+    unsigned long long state;
+public:
+    LogGenRandom(unsigned int seed) : state(seed * 2685821657736338717ULL + 1) {}
+
+    unsigned long long next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    // [0,1)
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    int range(int n) {
+        return (int) (uniform() * n);
+    }
+};
+
+// samples ranks 0..n-1 with probability proportional to 1/(rank+1)^skew
+class ZipfDistribution {
+    std::vector<double> cdf;
+public:
+    ZipfDistribution(int n, double skew) {
+        cdf.resize(n);
+
+        double total = 0.0;
+
+        for(int i=0; i<n; i++) {
+            total += 1.0 / pow((double) (i+1), skew);
+            cdf[i] = total;
+        }
+
+        for(int i=0; i<n; i++) {
+            cdf[i] /= total;
+        }
+    }
+
+    int sample(LogGenRandom& random) const {
+        double u = random.uniform();
+        int rank = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        return std::min(rank, (int) cdf.size() - 1);
+    }
+};
+
+const char* loggen_extensions[] = { ".html", ".css", ".js", ".jpg", ".png", ".gif", ".php", "" };
+const char* loggen_success[]    = { "200", "200", "200", "200", "200", "304", "301", "302" };
+const char* loggen_errors[]     = { "404", "404", "404", "403", "500", "502", "503" };
+const char* loggen_agents[]     = {
+    "Mozilla/5.0 (X11; Linux x86_64; rv:45.0) Gecko/20100101 Firefox/45.0",
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/50.0 Safari/537.36",
+    "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_11_4) AppleWebKit/601.5.17 (KHTML, like Gecko) Version/9.1 Safari/601.5.17",
+    "curl/7.47.0"
+};
+
+#define LOGGEN_COUNT(array) ((int) (sizeof(array) / sizeof(array[0])))
+
+// scramble a rank so popular items are not numbered sequentially
+unsigned int loggen_hash(unsigned int x) {
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = (x >> 16) ^ x;
+    return x;
+}
+
+void loggen_url(int rank, char* buff, size_t size) {
+    unsigned int h = loggen_hash(rank);
+
+    snprintf(buff, size, "/section%u/category%u/page%d%s",
+             h % 16, (h >> 4) % 64, rank, loggen_extensions[(h >> 10) % LOGGEN_COUNT(loggen_extensions)]);
+}
+
+void loggen_host(int rank, char* buff, size_t size) {
+    unsigned int h = loggen_hash(rank + 0x9e3779b9);
+
+    if(h % 4 == 0) {
+        snprintf(buff, size, "host-%d.isp%u.example.net", rank, (h >> 2) % 100);
+    } else {
+        snprintf(buff, size, "%u.%u.%u.%u", 1 + (h >> 24) % 223, (h >> 16) & 0xff, (h >> 8) & 0xff, 1 + (h % 254));
+    }
+}
+
+// sends lines to localhost as syslog messages, like nginx's
+// 'access_log syslog:server=...'. TCP messages are newline terminated for
+// RFC 3164 and octet counted for RFC 5424.
+
+class SyslogSender {
+    int fd;
+    bool tcp;
+    bool rfc5424;
+    std::vector<char> message;
+public:
+    SyslogSender(const std::string& endpoint, bool rfc5424) : fd(-1), tcp(false), rfc5424(rfc5424) {
+
+        message.resize(8192);
+
+#ifndef _WIN32
+        size_t colon = endpoint.find(':');
+
+        if(colon == std::string::npos) return;
+
+        std::string protocol = endpoint.substr(0, colon);
+        int port = atoi(endpoint.c_str() + colon + 1);
+
+        if(protocol == "tcp") tcp = true;
+        else if(protocol != "udp") return;
+
+        if(port < 1 || port > 65535) return;
+
+        fd = socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+
+        if(fd < 0) return;
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    ~SyslogSender() {
+#ifndef _WIN32
+        if(fd >= 0) close(fd);
+#endif
+    }
+
+    bool isConnected() const { return fd >= 0; }
+
+    // send a line (without its newline) as one message
+    bool send(const char* line, int length) {
+#ifndef _WIN32
+        char header[128];
+        time_t now = time(0);
+        struct tm* tm = gmtime(&now);
+
+        // local7.info
+        int header_length;
+
+        if(rfc5424) {
+            char date[64];
+            strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+            header_length = snprintf(header, sizeof(header), "<190>1 %s loggen nginx - - - ", date);
+        } else {
+            char date[64];
+            strftime(date, sizeof(date), "%b %e %H:%M:%S", tm);
+            header_length = snprintf(header, sizeof(header), "<190>%s loggen nginx: ", date);
+        }
+
+        int message_length = header_length + length;
+        int offset = 0;
+
+        if(tcp && rfc5424) {
+            offset = snprintf(&(message[0]), message.size(), "%d ", message_length);
+        }
+
+        if(offset + message_length + 1 > (int) message.size()) return true;
+
+        memcpy(&(message[offset]), header, header_length);
+        memcpy(&(message[offset + header_length]), line, length);
+
+        int total = offset + message_length;
+
+        if(tcp && !rfc5424) message[total++] = '\n';
+
+        return ::send(fd, &(message[0]), total, 0) == total || !tcp;
+#else
+        return false;
+#endif
+    }
+};
+
+class LogGenerator {
+    LogGenSettings& settings;
+    LogGenRandom random;
+
+    ZipfDistribution url_distribution;
+    ZipfDistribution host_distribution;
+
+    std::vector<char> line;
+public:
+    SyslogSender* sender;
+    bool failed;
+
+    LogGenerator(LogGenSettings& settings)
+        : settings(settings), random(settings.seed),
+          url_distribution(settings.urls, settings.url_skew),
+          host_distribution(settings.hosts, settings.host_skew) {
+        line.resize(4096);
+        sender = 0;
+        failed = false;
+    }
+
+    // requests per second at a given offset in seconds
+    double rateAt(double t) const {
+        if(settings.burst_period > 0.0 && fmod(t, settings.burst_period) < settings.burst_length) {
+            return settings.rate * settings.burst_factor;
+        }
+        return settings.rate;
+    }
+
+    void write(time_t timestamp, FILE* out) {
+
+        char url[256], host[256], vhost[64];
+
+        loggen_url(url_distribution.sample(random), url, sizeof(url));
+        loggen_host(host_distribution.sample(random), host, sizeof(host));
+
+        const char* code = (random.uniform() < settings.error_ratio)
+            ? loggen_errors[random.range(LOGGEN_COUNT(loggen_errors))]
+            : loggen_success[random.range(LOGGEN_COUNT(loggen_success))];
+
+        const char* agent = loggen_agents[random.range(LOGGEN_COUNT(loggen_agents))];
+
+        int bytes = 200 + (int) (-log(1.0 - random.uniform()) * 20000.0);
+
+        vhost[0] = '\0';
+        if(settings.vhosts > 0) snprintf(vhost, sizeof(vhost), "www%d.example.com", random.range(settings.vhosts));
+
+        int length;
+
+        if(settings.format == LOGGEN_FORMAT_CUSTOM) {
+
+            char pid[32];
+            pid[0] = '\0';
+            if(settings.pids > 0) snprintf(pid, sizeof(pid), "%d", 1000 + random.range(settings.pids));
+
+            // timestamp|host|path|code|size|success|colour|referrer|agent|vhost|pid
+            length = snprintf(&(line[0]), line.size(), "%ld|%s|%s|%s|%d||||%s|%s|%s\n",
+                              (long) timestamp, host, url, code, bytes, agent, vhost, pid);
+        } else if(settings.format == LOGGEN_FORMAT_JSON) {
+
+            char date[64];
+            struct tm* tm = gmtime(&timestamp);
+            strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S+00:00", tm);
+
+            // nginx log_format escape=json
+            length = snprintf(&(line[0]), line.size(),
+                              "{\"time_iso8601\":\"%s\",\"remote_addr\":\"%s\",\"host\":\"%s\",\"request\":\"GET %s HTTP/1.1\","
+                              "\"status\":\"%s\",\"body_bytes_sent\":\"%d\",\"request_time\":\"%.3f\",\"http_referer\":\"\","
+                              "\"http_user_agent\":\"%s\"}\n",
+                              date, host, vhost, url, code, bytes, -log(1.0 - random.uniform()) * 0.05, agent);
+        } else {
+            char date[64];
+            struct tm* tm = gmtime(&timestamp);
+            strftime(date, sizeof(date), "%d/%b/%Y:%H:%M:%S +0000", tm);
+
+            length = snprintf(&(line[0]), line.size(), "%s%s%s - - [%s] \"GET %s HTTP/1.1\" %s %d \"-\" \"%s\"\n",
+                              vhost, vhost[0] ? " " : "", host, date, url, code, bytes, agent);
+        }
+
+        if(length <= 0) return;
+
+        length = std::min(length, (int) line.size() - 1);
+
+        if(sender != 0) {
+            if(line[length-1] == '\n') length--;
+
+            if(!sender->send(&(line[0]), length)) failed = true;
+        } else {
+            fwrite(&(line[0]), 1, length, out);
+        }
+    }
+
+    // write the whole period as fast as possible with simulated timestamps
+    void generate(FILE* out) {
+
+        long written = 0;
+        double carry = 0.0;
+
+        for(long second = 0; ; second++) {
+
+            if(settings.count == 0 && second >= settings.duration) break;
+
+            double expected = rateAt(second) + carry;
+            long lines = (long) expected;
+            carry = expected - lines;
+
+            for(long i=0; i<lines; i++) {
+                if(settings.count > 0 && written >= settings.count) return;
+
+                write(settings.start + second, out);
+                written++;
+            }
+        }
+    }
+
+    // write lines in real time with the current time
+    void stream(FILE* out) {
+
+        typedef std::chrono::steady_clock clock;
+
+        clock::time_point begin = clock::now();
+
+        double due = 0.0;
+        long written = 0;
+        double last_t = 0.0;
+
+        while(true) {
+
+            double t = std::chrono::duration<double>(clock::now() - begin).count();
+
+            if(settings.count == 0 && settings.duration > 0.0 && t >= settings.duration) break;
+
+            // integrate the rate over the elapsed interval
+            due += rateAt(t) * (t - last_t);
+            last_t = t;
+
+            time_t now = time(0);
+
+            while(due >= 1.0) {
+                if(settings.count > 0 && written >= settings.count) return;
+
+                write(now, out);
+                written++;
+                due -= 1.0;
+            }
+
+            fflush(out);
+
+            if(ferror(out) || failed) return;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+};
+
+void loggen_usage() {
+    printf("usage: logstalgia-loggen [options]\n\n");
+    printf("  --format FORMAT         Log format: ncsa, custom or json (default: ncsa)\n");
+    printf("  --rate N                Requests per second (default: 100)\n");
+    printf("  --duration SECONDS      Seconds of log to write (default: 60, 0 for no limit when streaming)\n");
+    printf("  --count N               Stop after N lines (overrides --duration)\n");
+    printf("  --urls N                Distinct URLs (default: 10000)\n");
+    printf("  --hosts N               Distinct hosts (default: 1000)\n");
+    printf("  --url-skew S            Zipf exponent of URL popularity (default: 1.0)\n");
+    printf("  --host-skew S           Zipf exponent of host activity (default: 1.0)\n");
+    printf("  --vhosts N              Distinct virtual hosts (default: none)\n");
+    printf("  --pids N                Distinct pids (custom format only, default: none)\n");
+    printf("  --burst-period SECONDS  Interval between bursts\n");
+    printf("  --burst-length SECONDS  Length of each burst\n");
+    printf("  --burst-factor F        Rate multiplier during a burst (default: 10)\n");
+    printf("  --error-ratio R         Fraction of 4xx/5xx responses (default: 0.02)\n");
+    printf("  --start TIMESTAMP       Unix time of the first entry (default: 1262304000)\n");
+    printf("  --seed N                Random seed (default: 1)\n");
+    printf("  --stream                Write in real time with the current time\n");
+    printf("  --syslog PROTOCOL:PORT  Send to a localhost port as syslog messages (udp or tcp)\n");
+    printf("  --rfc5424               Use RFC 5424 syslog headers (default: RFC 3164)\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+    LogGenSettings settings;
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+
+        if(arg == "--stream") {
+            settings.stream = true;
+            continue;
+        }
+
+        if(arg == "--rfc5424") {
+            settings.rfc5424 = true;
+            continue;
+        }
+
+        if(arg == "--help" || arg == "-h" || i+1 >= argc) loggen_usage();
+
+        const char* value = argv[++i];
+
+        if(arg == "--format") {
+            if(strcmp(value, "ncsa") == 0)        settings.format = LOGGEN_FORMAT_NCSA;
+            else if(strcmp(value, "custom") == 0) settings.format = LOGGEN_FORMAT_CUSTOM;
+            else if(strcmp(value, "json") == 0)   settings.format = LOGGEN_FORMAT_JSON;
+            else loggen_usage();
+        }
+        else if(arg == "--rate")         settings.rate         = atof(value);
+        else if(arg == "--duration")     settings.duration     = atof(value);
+        else if(arg == "--count")        settings.count        = atol(value);
+        else if(arg == "--urls")         settings.urls         = atoi(value);
+        else if(arg == "--hosts")        settings.hosts        = atoi(value);
+        else if(arg == "--url-skew")     settings.url_skew     = atof(value);
+        else if(arg == "--host-skew")    settings.host_skew    = atof(value);
+        else if(arg == "--vhosts")       settings.vhosts       = atoi(value);
+        else if(arg == "--pids")         settings.pids         = atoi(value);
+        else if(arg == "--burst-period") settings.burst_period = atof(value);
+        else if(arg == "--burst-length") settings.burst_length = atof(value);
+        else if(arg == "--burst-factor") settings.burst_factor = atof(value);
+        else if(arg == "--error-ratio")  settings.error_ratio  = atof(value);
+        else if(arg == "--start")        settings.start        = atol(value);
+        else if(arg == "--seed")         settings.seed         = (unsigned int) atol(value);
+        else if(arg == "--syslog")       settings.syslog       = value;
+        else loggen_usage();
+    }
+
+    if(settings.rate <= 0.0 || settings.urls < 1 || settings.hosts < 1 || settings.count < 0) {
+        loggen_usage();
+    }
+
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    LogGenerator generator(settings);
+
+    SyslogSender* sender = 0;
+
+    if(!settings.syslog.empty()) {
+        sender = new SyslogSender(settings.syslog, settings.rfc5424);
+
+        if(!sender->isConnected()) {
+            fprintf(stderr, "could not connect to syslog port %s\n", settings.syslog.c_str());
+            return 1;
+        }
+
+        generator.sender = sender;
+    }
+
+    if(settings.stream) {
+        generator.stream(stdout);
+    } else {
+        generator.generate(stdout);
+    }
+
+    fflush(stdout);
+
+    if(sender != 0) delete sender;
+
+    return generator.failed ? 1 : 0;
+}
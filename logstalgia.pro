@@ -28,17 +28,35 @@ mingw {
 
 VPATH += ./src
 
-SOURCES += custom.cpp \
+SOURCES += backgroundlog.cpp \
+    compiledlog.cpp \
+    custom.cpp \
+    entryqueue.cpp \
+    exporter.cpp \
+    followlog.cpp \
+    formatlog.cpp \
+    headless.cpp \
+    jsonlog.cpp \
+    keyframes.cpp \
     logentry.cpp \
+    logformat.cpp \
     logstalgia.cpp \
     main.cpp \
+    metrics.cpp \
     ncsa.cpp \
     paddle.cpp \
+    profiler.cpp \
+    reorderbuffer.cpp \
     requestball.cpp \
+    sampler.cpp \
+    segments.cpp \
     settings.cpp \
     slider.cpp \
+    stdinlog.cpp \
     summarizer.cpp \
+    sysloglog.cpp \
     textarea.cpp \
+    trace.cpp \
     core/conffile.cpp \
     core/display.cpp \
     core/frustum.cpp \
@@ -61,16 +79,34 @@ SOURCES += custom.cpp \
     core/vbo.cpp \
     core/vectors.cpp
 
-HEADERS += custom.h \
+HEADERS += backgroundlog.h \
+    compiledlog.h \
+    custom.h \
+    entryqueue.h \
+    exporter.h \
+    followlog.h \
+    formatlog.h \
+    headless.h \
+    jsonlog.h \
+    keyframes.h \
     logentry.h \
+    logformat.h \
     logstalgia.h \
+    metrics.h \
     ncsa.h \
     paddle.h \
+    profiler.h \
+    reorderbuffer.h \
     requestball.h \
+    sampler.h \
+    segments.h \
     settings.h \
     slider.h \
+    stdinlog.h \
     summarizer.h \
+    sysloglog.h \
     textarea.h \
+    trace.h \
     core/bounds.h \
     core/conffile.h \
     core/display.h \
@@ -0,0 +1,208 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "backgroundlog.h"
+
+#include <string.h>
+#include <iterator>
+
+// BackgroundLogChannel
+
+BackgroundLogChannel::BackgroundLogChannel() {
+    finished   = false;
+    stopping   = false;
+    references = 1;
+
+    mutex       = SDL_CreateMutex();
+    lines_taken = SDL_CreateCond();
+}
+
+BackgroundLogChannel::~BackgroundLogChannel() {
+    SDL_DestroyCond(lines_taken);
+    SDL_DestroyMutex(mutex);
+}
+
+void BackgroundLogChannel::retain() {
+    references++;
+}
+
+void BackgroundLogChannel::release() {
+    if(--references == 0) delete this;
+}
+
+void BackgroundLogChannel::publish(std::vector<ReceivedLine>& lines) {
+
+    if(lines.empty()) return;
+
+    SDL_mutexP(mutex);
+
+    while(!stopping && incoming.size() >= BACKGROUND_LOG_MAX_LINES) {
+        SDL_CondWait(lines_taken, mutex);
+    }
+
+    if(incoming.empty()) {
+        incoming.swap(lines);
+    } else {
+        incoming.insert(incoming.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+    }
+
+    SDL_mutexV(mutex);
+
+    lines.clear();
+}
+
+void BackgroundLogChannel::finish() {
+    SDL_mutexP(mutex);
+    finished = true;
+    SDL_mutexV(mutex);
+}
+
+void BackgroundLogChannel::stop() {
+    SDL_mutexP(mutex);
+    stopping = true;
+    SDL_CondSignal(lines_taken);
+    SDL_mutexV(mutex);
+}
+
+void BackgroundLogChannel::take(std::vector<ReceivedLine>& batch) {
+
+    SDL_mutexP(mutex);
+
+    if(!incoming.empty()) {
+        batch.swap(incoming);
+        SDL_CondSignal(lines_taken);
+    }
+
+    SDL_mutexV(mutex);
+}
+
+bool BackgroundLogChannel::isFinished() {
+
+    SDL_mutexP(mutex);
+    bool done = finished && incoming.empty();
+    SDL_mutexV(mutex);
+
+    return done;
+}
+
+// BackgroundLog
+
+BackgroundLog::BackgroundLog() {
+    thread        = 0;
+    batch_pos     = 0;
+    last_received = 0;
+
+    channel = new BackgroundLogChannel();
+}
+
+BackgroundLog::~BackgroundLog() {
+    channel->release();
+}
+
+void BackgroundLog::startThread(int (*reader_thread)(void*), void* reader) {
+
+    ReaderStart* start = new ReaderStart();
+    start->reader  = reader;
+    start->channel = channel;
+
+    channel->retain();
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    thread = SDL_CreateThread(reader_thread, "log_reader", start);
+#else
+    thread = SDL_CreateThread(reader_thread, start);
+#endif
+
+    if(thread == 0) {
+        delete start;
+        channel->finish();
+        channel->release();
+    }
+}
+
+// NOTE: called by subclass destructors while readInput() can still be used
+void BackgroundLog::stop(bool wait) {
+
+    if(thread == 0) return;
+
+    channel->stop();
+
+    wake();
+
+    if(wait) {
+        SDL_WaitThread(thread, 0);
+    } else {
+#if SDL_VERSION_ATLEAST(2,0,2)
+        SDL_DetachThread(thread);
+#endif
+    }
+
+    thread = 0;
+}
+
+void BackgroundLog::splitLines(const char* p, const char* end, Uint64 received, std::string& partial, std::vector<ReceivedLine>& lines) {
+
+    //memchr compares a vector of bytes at a time
+    const char* eol;
+
+    while((eol = (const char*) memchr(p, '\n', end - p)) != 0) {
+
+        lines.push_back(ReceivedLine());
+
+        ReceivedLine& line = lines.back();
+        line.received      = received;
+
+        if(partial.empty()) {
+            line.text.assign(p, eol - p);
+        } else {
+            partial.append(p, eol - p);
+            line.text.swap(partial);
+        }
+
+        p = eol + 1;
+    }
+
+    partial.append(p, end - p);
+}
+
+bool BackgroundLog::getNextLine(std::string& line) {
+
+    if(batch_pos >= batch.size()) {
+
+        batch.clear();
+        batch_pos = 0;
+
+        //take everything published so far in one go
+        channel->take(batch);
+
+        if(batch.empty()) return false;
+    }
+
+    ReceivedLine& next = batch[batch_pos++];
+
+    line.swap(next.text);
+    last_received = next.received;
+
+    return true;
+}
+
+bool BackgroundLog::isFinished() {
+
+    if(batch_pos < batch.size()) return false;
+
+    return channel->isFinished();
+}
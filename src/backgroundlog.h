@@ -0,0 +1,137 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_BACKGROUNDLOG_H
+#define LOGSTALGIA_BACKGROUNDLOG_H
+
+#include "core/seeklog.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+// lines waiting to be collected before the reader stops reading
+#define BACKGROUND_LOG_MAX_LINES 65536
+
+struct ReceivedLine {
+    std::string text;
+    Uint64 received;
+};
+
+// State shared by a background log and its reader thread. The log and the
+// thread each hold a reference and whichever lets go last frees it, so a
+// reader left running by stop(false) never uses the log after it is gone.
+
+class BackgroundLogChannel {
+    SDL_mutex* mutex;
+    SDL_cond*  lines_taken;
+
+    // lines published by the reader
+    std::vector<ReceivedLine> incoming;
+
+    bool finished;
+
+    std::atomic<int> references;
+public:
+    std::atomic<bool> stopping;
+
+    BackgroundLogChannel();
+    ~BackgroundLogChannel();
+
+    void retain();
+    void release();
+
+    // hands lines to the log, waiting while it is too far behind
+    void publish(std::vector<ReceivedLine>& lines);
+
+    void finish();
+    void stop();
+
+    // moves the lines published so far into the batch
+    void take(std::vector<ReceivedLine>& batch);
+
+    bool isFinished();
+};
+
+// A log received by a background thread so waiting for input never blocks
+// a frame. Subclasses implement readInput(channel) to wait for input and
+// publish() the lines received to the channel, which are handed to the main
+// thread in batches. When too many lines are waiting publish() blocks, so
+// the reader stops reading and applies backpressure to the sender.
+
+class BackgroundLog : public BaseLog {
+    SDL_Thread* thread;
+    BackgroundLogChannel* channel;
+
+    // batch being returned by getNextLine
+    std::vector<ReceivedLine> batch;
+    size_t batch_pos;
+
+    Uint64 last_received;
+
+    void startThread(int (*reader_thread)(void*), void* reader);
+
+    struct ReaderStart {
+        void* reader;
+        BackgroundLogChannel* channel;
+    };
+
+    // readInput() is called without virtual dispatch, so nothing of the log
+    // is used once it returns and a detached reader can outlive the log
+    template<class Reader>
+    static int readerThread(void* data) {
+        ReaderStart* start = static_cast<ReaderStart*>(data);
+
+        Reader* reader = static_cast<Reader*>(start->reader);
+        BackgroundLogChannel* channel = start->channel;
+
+        delete start;
+
+        reader->Reader::readInput(*channel);
+
+        channel->finish();
+        channel->release();
+
+        return 0;
+    }
+protected:
+    template<class Reader>
+    void start(Reader* reader) {
+        startThread(readerThread<Reader>, reader);
+    }
+
+    // wait = false leaves the reader running, for readers that can't be
+    // interrupted. Once blocked they must only use the channel and locals
+    void stop(bool wait = true);
+
+    // interrupt the reader waiting for input
+    virtual void wake() {};
+
+    // appends the complete lines in a chunk of input, keeping the remainder
+    static void splitLines(const char* p, const char* end, Uint64 received, std::string& partial, std::vector<ReceivedLine>& lines);
+public:
+    BackgroundLog();
+    virtual ~BackgroundLog();
+
+    bool getNextLine(std::string& line);
+    bool isFinished();
+
+    // profiler ticks when the last line returned was received
+    Uint64 lastReceived() const { return last_received; };
+};
+
+#endif
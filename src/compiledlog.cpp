@@ -0,0 +1,675 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compiledlog.h"
+#include "settings.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static size_t compiled_log_put_varint(FILE* stream, uint64_t value) {
+    uint8_t buffer[10];
+    size_t size = 0;
+
+    while(value >= 0x80) {
+        buffer[size++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    buffer[size++] = value;
+
+    fwrite(buffer, 1, size, stream);
+
+    return size;
+}
+
+static bool compiled_log_get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+
+    for(int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+
+        value |= (uint64_t) (byte & 0x7f) << shift;
+
+        if(!(byte & 0x80)) return true;
+    }
+
+    return false;
+}
+
+// true if size bytes at offset are within length
+static bool compiled_log_in_range(uint64_t offset, uint64_t size, uint64_t length) {
+    return offset <= length && size <= length - offset;
+}
+
+//LogCompiler
+
+LogCompiler::LogCompiler(const std::string& filename) : filename(filename) {
+
+    entries        = 0;
+    deltas_length  = 0;
+    sizes_length   = 0;
+    last_timestamp = 0;
+    offset         = 0;
+
+    deltas = sizes = times = 0;
+
+    for(int i=0; i<COMPILED_LOG_COLUMNS; i++) {
+        values[i] = 0;
+    }
+
+    output = fopen(filename.c_str(), "wb");
+
+    if(output == 0) {
+        throw CompiledLogException("could not write to '" + filename + "'");
+    }
+
+    bool created = (deltas = tmpfile()) != 0 && (sizes = tmpfile()) != 0 && (times = tmpfile()) != 0;
+
+    for(int i=0; created && i<COMPILED_LOG_COLUMNS; i++) {
+        created = (values[i] = tmpfile()) != 0;
+    }
+
+    if(!created) {
+        close();
+        remove(filename.c_str());
+        throw CompiledLogException("could not create a temporary file");
+    }
+}
+
+LogCompiler::~LogCompiler() {
+    //not finished
+    if(output != 0) {
+        close();
+        remove(filename.c_str());
+    }
+}
+
+void LogCompiler::close() {
+    if(output != 0) fclose(output);
+    output = 0;
+
+    if(deltas != 0) fclose(deltas);
+    if(sizes != 0)  fclose(sizes);
+    if(times != 0)  fclose(times);
+
+    deltas = sizes = times = 0;
+
+    for(int i=0; i<COMPILED_LOG_COLUMNS; i++) {
+        if(values[i] != 0) fclose(values[i]);
+        values[i] = 0;
+    }
+}
+
+void LogCompiler::addValue(int column, const std::string& value) {
+
+    auto result = dictionaries[column].insert(std::make_pair(value, (uint32_t) dictionary_strings[column].size()));
+
+    //keys of an unordered_map don't move, so point at them rather than copy them again
+    if(result.second) dictionary_strings[column].push_back(&(result.first->first));
+
+    uint32_t index = result.first->second;
+
+    fwrite(&index, sizeof(uint32_t), 1, values[column]);
+}
+
+void LogCompiler::add(const LogEntry& entry) {
+
+    if(entries % COMPILED_LOG_BLOCK == 0) {
+        CompiledLogBlock block;
+        block.timestamp    = entry.timestamp;
+        block.delta_offset = deltas_length;
+        block.size_offset  = sizes_length;
+
+        index.push_back(block);
+
+        last_timestamp = entry.timestamp;
+    }
+
+    //zigzag encoded so entries slightly out of order stay small
+    int64_t delta   = (int64_t) entry.timestamp - (int64_t) last_timestamp;
+    uint64_t zigzag = ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63);
+
+    deltas_length += compiled_log_put_varint(deltas, zigzag);
+    last_timestamp = entry.timestamp;
+
+    sizes_length += compiled_log_put_varint(sizes, entry.response_size > 0 ? entry.response_size : 0);
+
+    fwrite(&entry.request_time, sizeof(float), 1, times);
+
+    addValue(COMPILED_LOG_HOSTNAME,      entry.hostname);
+    addValue(COMPILED_LOG_VHOST,         entry.vhost);
+    addValue(COMPILED_LOG_PATH,          entry.path);
+    addValue(COMPILED_LOG_PID,           entry.pid);
+    addValue(COMPILED_LOG_RESPONSE_CODE, entry.response_code);
+    addValue(COMPILED_LOG_REFERRER,      entry.referrer);
+    addValue(COMPILED_LOG_USER_AGENT,    entry.user_agent);
+    addValue(COMPILED_LOG_UPSTREAM,      entry.upstream);
+
+    entries++;
+}
+
+void LogCompiler::write(const void* buffer, size_t size) {
+    if(size == 0) return;
+    fwrite(buffer, 1, size, output);
+    offset += size;
+}
+
+uint64_t LogCompiler::align() {
+    static const char padding[8] = { 0 };
+
+    if(offset % 8 != 0) write(padding, 8 - offset % 8);
+
+    return offset;
+}
+
+uint64_t LogCompiler::copy(FILE* stream) {
+
+    char buffer[65536];
+    uint64_t copied = 0;
+    size_t size;
+
+    rewind(stream);
+
+    while((size = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+        write(buffer, size);
+        copied += size;
+    }
+
+    return copied;
+}
+
+void LogCompiler::writeColumn(int column, CompiledLogColumn& column_header) {
+
+    const std::vector<const std::string*>& strings = dictionary_strings[column];
+
+    uint32_t count = strings.size();
+
+    column_header.dictionary_count = count;
+    column_header.width = count <= 0x100 ? 1 : count <= 0x10000 ? 2 : 4;
+
+    column_header.dictionary_offset = align();
+
+    uint64_t string_offset = 0;
+
+    for(const std::string* value : strings) {
+        write(&string_offset, sizeof(uint64_t));
+        string_offset += value->size();
+    }
+    write(&string_offset, sizeof(uint64_t));
+
+    for(const std::string* value : strings) {
+        write(value->data(), value->size());
+    }
+
+    column_header.values_offset = align();
+
+    //narrow the indexes to the width needed
+    uint32_t indexes[16384];
+    uint8_t narrowed[16384 * 4];
+    size_t read;
+
+    rewind(values[column]);
+
+    while((read = fread(indexes, sizeof(uint32_t), 16384, values[column])) > 0) {
+
+        for(size_t i=0; i<read; i++) {
+            switch(column_header.width) {
+                case 1:
+                    narrowed[i] = indexes[i];
+                    break;
+                case 2: {
+                    uint16_t index = indexes[i];
+                    memcpy(narrowed + i*2, &index, 2);
+                    break;
+                }
+                default:
+                    memcpy(narrowed + i*4, &indexes[i], 4);
+                    break;
+            }
+        }
+
+        write(narrowed, read * column_header.width);
+    }
+}
+
+void LogCompiler::finish() {
+
+    CompiledLogHeader header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, COMPILED_LOG_MAGIC, sizeof(header.magic));
+    header.version       = COMPILED_LOG_VERSION;
+    header.block_entries = COMPILED_LOG_BLOCK;
+    header.entries       = entries;
+    header.blocks        = index.size();
+
+    //written again once the offsets are known
+    write(&header, sizeof(header));
+
+    header.index_offset = align();
+    write(index.data(), index.size() * sizeof(CompiledLogBlock));
+
+    header.deltas_offset = align();
+    header.deltas_length = copy(deltas);
+
+    header.sizes_offset = align();
+    header.sizes_length = copy(sizes);
+
+    header.times_offset = align();
+    copy(times);
+
+    for(int i=0; i<COMPILED_LOG_COLUMNS; i++) {
+        writeColumn(i, header.columns[i]);
+    }
+
+    fseek(output, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, output);
+
+    bool failed = ferror(output) != 0;
+
+    for(int i=0; i<COMPILED_LOG_COLUMNS; i++) {
+        if(ferror(values[i])) failed = true;
+    }
+
+    if(ferror(deltas) || ferror(sizes) || ferror(times)) failed = true;
+
+    if(fclose(output) != 0) failed = true;
+    output = 0;
+
+    close();
+
+    if(failed) {
+        remove(filename.c_str());
+        throw CompiledLogException("error writing '" + filename + "'");
+    }
+
+    debugLog("compiled %llu entries to %s (%llu bytes)", (unsigned long long) entries, filename.c_str(), (unsigned long long) offset);
+}
+
+//CompiledLog
+
+CompiledLog::CompiledLog(const std::string& filename) : filename(filename) {
+
+    data   = 0;
+    length = 0;
+
+    position = 0;
+    current  = 0;
+
+    decoded           = 0;
+    delta_pos         = 0;
+    size_pos          = 0;
+    decoded_timestamp = 0;
+
+    map();
+
+    try {
+        validate();
+    } catch(CompiledLogException& exception) {
+        unmap();
+        throw;
+    }
+
+    //mask each distinct hostname once rather than every entry
+    if(settings.mask_hostnames) {
+        LogEntry masker;
+
+        masked_hostnames.resize(header.columns[COMPILED_LOG_HOSTNAME].dictionary_count);
+
+        for(uint32_t i=0; i<masked_hostnames.size(); i++) {
+            std::string hostname;
+            readDictionary(COMPILED_LOG_HOSTNAME, i, hostname);
+            masked_hostnames[i] = masker.maskHostname(hostname);
+        }
+    }
+
+    uint32_t response_codes = header.columns[COMPILED_LOG_RESPONSE_CODE].dictionary_count;
+
+    response_successful.resize(response_codes);
+    response_colours.resize(response_codes);
+
+    for(uint32_t i=0; i<response_codes; i++) {
+        LogEntry entry;
+        readDictionary(COMPILED_LOG_RESPONSE_CODE, i, entry.response_code);
+
+        entry.setSuccess();
+        entry.setResponseColour();
+
+        response_successful[i] = entry.successful;
+        response_colours[i]    = entry.response_colour;
+    }
+}
+
+CompiledLog::~CompiledLog() {
+    unmap();
+}
+
+bool CompiledLog::isCompiledLog(const std::string& filename) {
+
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if(file == 0) return false;
+
+    char magic[8];
+
+    bool compiled = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, COMPILED_LOG_MAGIC, sizeof(magic)) == 0;
+
+    fclose(file);
+
+    return compiled;
+}
+
+void CompiledLog::map() {
+
+#ifdef _WIN32
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if(file == 0) throw CompiledLogException("unable to read log file");
+
+    uint8_t buffer[65536];
+    size_t read;
+
+    while((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + read);
+    }
+
+    fclose(file);
+
+    data   = contents.data();
+    length = contents.size();
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if(fd == -1) throw CompiledLogException("unable to read log file");
+
+    struct stat file_stat;
+
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(CompiledLogHeader)) {
+        ::close(fd);
+        throw CompiledLogException("not a compiled log file");
+    }
+
+    void* mapped = mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    ::close(fd);
+
+    if(mapped == MAP_FAILED) throw CompiledLogException("unable to map log file");
+
+#ifdef MADV_SEQUENTIAL
+    madvise(mapped, file_stat.st_size, MADV_SEQUENTIAL);
+#endif
+
+    data   = (const uint8_t*) mapped;
+    length = file_stat.st_size;
+#endif
+}
+
+void CompiledLog::unmap() {
+#ifdef _WIN32
+    contents.clear();
+#else
+    if(data != 0) munmap((void*) data, length);
+#endif
+    data   = 0;
+    length = 0;
+}
+
+void CompiledLog::validate() {
+
+    if(length < sizeof(header)) throw CompiledLogException("not a compiled log file");
+
+    memcpy(&header, data, sizeof(header));
+
+    if(memcmp(header.magic, COMPILED_LOG_MAGIC, sizeof(header.magic)) != 0) {
+        throw CompiledLogException("not a compiled log file");
+    }
+
+    if(header.version != COMPILED_LOG_VERSION) {
+        throw CompiledLogException("unsupported compiled log version");
+    }
+
+    //every entry takes at least one byte of each stream, which also
+    //keeps the sizes below from overflowing
+    bool valid = header.block_entries > 0 && header.entries <= length
+        && header.blocks == (header.entries + header.block_entries - 1) / header.block_entries
+        && compiled_log_in_range(header.index_offset,  header.blocks * sizeof(CompiledLogBlock), length)
+        && compiled_log_in_range(header.deltas_offset, header.deltas_length, length)
+        && compiled_log_in_range(header.sizes_offset,  header.sizes_length, length)
+        && compiled_log_in_range(header.times_offset,  header.entries * sizeof(float), length);
+
+    for(uint64_t i=0; valid && i<header.blocks; i++) {
+        CompiledLogBlock block;
+        memcpy(&block, data + header.index_offset + i * sizeof(CompiledLogBlock), sizeof(block));
+
+        valid = block.delta_offset <= header.deltas_length && block.size_offset <= header.sizes_length;
+    }
+
+    for(int i=0; valid && i<COMPILED_LOG_COLUMNS; i++) {
+        const CompiledLogColumn& column = header.columns[i];
+
+        valid = (column.width == 1 || column.width == 2 || column.width == 4)
+            && (header.entries == 0 || column.dictionary_count > 0)
+            && compiled_log_in_range(column.dictionary_offset, ((uint64_t) column.dictionary_count + 1) * sizeof(uint64_t), length)
+            && compiled_log_in_range(column.values_offset, header.entries * column.width, length);
+
+        if(!valid) break;
+
+        dictionaries[i] = data + column.dictionary_offset;
+        values[i]       = data + column.values_offset;
+
+        uint64_t strings_offset = column.dictionary_offset + ((uint64_t) column.dictionary_count + 1) * sizeof(uint64_t);
+
+        //string offsets must be in order and the last within the file
+        uint64_t previous = 0;
+
+        for(uint32_t j=0; valid && j<=column.dictionary_count; j++) {
+            uint64_t string_offset;
+            memcpy(&string_offset, dictionaries[i] + j * sizeof(uint64_t), sizeof(uint64_t));
+
+            valid = string_offset >= previous;
+            previous = string_offset;
+        }
+
+        if(valid) valid = compiled_log_in_range(strings_offset, previous, length);
+    }
+
+    if(!valid) throw CompiledLogException("compiled log file is corrupt");
+}
+
+bool CompiledLog::decode(uint64_t entry, time_t& timestamp, uint64_t& size) {
+
+    uint64_t block = entry / header.block_entries;
+
+    //start from the block containing the entry unless it is ahead in the current block
+    if(entry < decoded || block != decoded / header.block_entries || delta_pos == 0) {
+
+        CompiledLogBlock index;
+        memcpy(&index, data + header.index_offset + block * sizeof(CompiledLogBlock), sizeof(index));
+
+        delta_pos = data + header.deltas_offset + index.delta_offset;
+        size_pos  = data + header.sizes_offset  + index.size_offset;
+        decoded   = block * header.block_entries;
+    }
+
+    const uint8_t* deltas_end = data + header.deltas_offset + header.deltas_length;
+    const uint8_t* sizes_end  = data + header.sizes_offset  + header.sizes_length;
+
+    while(decoded <= entry) {
+
+        //the first delta of each block is from the block timestamp
+        if(decoded % header.block_entries == 0) {
+            int64_t block_timestamp;
+            memcpy(&block_timestamp, data + header.index_offset + (decoded / header.block_entries) * sizeof(CompiledLogBlock), sizeof(block_timestamp));
+
+            decoded_timestamp = block_timestamp;
+        }
+
+        uint64_t zigzag;
+
+        if(!compiled_log_get_varint(delta_pos, deltas_end, zigzag) || !compiled_log_get_varint(size_pos, sizes_end, size)) {
+            //start again from the block next time
+            delta_pos = 0;
+            return false;
+        }
+
+        int64_t delta = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+
+        decoded_timestamp += delta;
+        decoded++;
+    }
+
+    timestamp = decoded_timestamp;
+
+    return true;
+}
+
+bool CompiledLog::readIndex(int column, uint64_t entry, uint32_t& index) {
+
+    const uint8_t* value = values[column] + entry * header.columns[column].width;
+
+    switch(header.columns[column].width) {
+        case 1:
+            index = *value;
+            break;
+        case 2: {
+            uint16_t narrow;
+            memcpy(&narrow, value, sizeof(narrow));
+            index = narrow;
+            break;
+        }
+        default:
+            memcpy(&index, value, sizeof(index));
+            break;
+    }
+
+    return index < header.columns[column].dictionary_count;
+}
+
+void CompiledLog::readDictionary(int column, uint32_t index, std::string& value) {
+
+    const CompiledLogColumn& header_column = header.columns[column];
+
+    uint64_t offsets[2];
+    memcpy(offsets, dictionaries[column] + index * sizeof(uint64_t), sizeof(offsets));
+
+    const uint8_t* strings = dictionaries[column] + ((uint64_t) header_column.dictionary_count + 1) * sizeof(uint64_t);
+
+    value.assign((const char*) strings + offsets[0], offsets[1] - offsets[0]);
+}
+
+bool CompiledLog::readEntry(LogEntry& entry) {
+
+    if(current >= header.entries) return false;
+
+    uint64_t size;
+
+    if(!decode(current, entry.timestamp, size)) return false;
+
+    entry.response_size = size;
+
+    memcpy(&entry.request_time, data + header.times_offset + current * sizeof(float), sizeof(float));
+
+    uint32_t indexes[COMPILED_LOG_COLUMNS];
+
+    for(int i=0; i<COMPILED_LOG_COLUMNS; i++) {
+        if(!readIndex(i, current, indexes[i])) return false;
+    }
+
+    if(!masked_hostnames.empty()) {
+        entry.hostname = masked_hostnames[indexes[COMPILED_LOG_HOSTNAME]];
+    } else {
+        readDictionary(COMPILED_LOG_HOSTNAME, indexes[COMPILED_LOG_HOSTNAME], entry.hostname);
+    }
+
+    readDictionary(COMPILED_LOG_VHOST,         indexes[COMPILED_LOG_VHOST],         entry.vhost);
+    readDictionary(COMPILED_LOG_PATH,          indexes[COMPILED_LOG_PATH],          entry.path);
+    readDictionary(COMPILED_LOG_PID,           indexes[COMPILED_LOG_PID],           entry.pid);
+    readDictionary(COMPILED_LOG_RESPONSE_CODE, indexes[COMPILED_LOG_RESPONSE_CODE], entry.response_code);
+    readDictionary(COMPILED_LOG_REFERRER,      indexes[COMPILED_LOG_REFERRER],      entry.referrer);
+    readDictionary(COMPILED_LOG_USER_AGENT,    indexes[COMPILED_LOG_USER_AGENT],    entry.user_agent);
+    readDictionary(COMPILED_LOG_UPSTREAM,      indexes[COMPILED_LOG_UPSTREAM],      entry.upstream);
+
+    entry.successful      = response_successful[indexes[COMPILED_LOG_RESPONSE_CODE]];
+    entry.response_colour = response_colours[indexes[COMPILED_LOG_RESPONSE_CODE]];
+
+    return true;
+}
+
+bool CompiledLog::getNextLine(std::string& line) {
+
+    if(position >= header.entries) return false;
+
+    current = position++;
+
+    line.clear();
+
+    return true;
+}
+
+bool CompiledLog::isFinished() {
+    return position >= header.entries;
+}
+
+void CompiledLog::seekTo(float percent) {
+
+    uint64_t entry = header.entries * (double) percent;
+
+    position = std::min(entry, header.entries);
+}
+
+float CompiledLog::getPercent() {
+
+    if(header.entries == 0) return 1.0f;
+
+    return position / (double) header.entries;
+}
+
+bool CompiledLog::getNextLineAt(std::string& line, float percent) {
+
+    uint64_t entry = header.entries * (double) percent;
+
+    if(entry >= header.entries) return false;
+
+    current = entry;
+
+    line.clear();
+
+    return true;
+}
+
+//CompiledAccessLog
+
+CompiledAccessLog::CompiledAccessLog(CompiledLog* log) : log(log) {
+}
+
+bool CompiledAccessLog::parseLine(std::string& line, LogEntry& entry) {
+
+    //fields were validated when compiled
+    if(!log->readEntry(entry)) return reject(PARSE_STAGE_VALIDATE);
+
+    return true;
+}
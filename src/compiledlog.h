@@ -0,0 +1,218 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_COMPILEDLOG_H
+#define LOGSTALGIA_COMPILEDLOG_H
+
+#include "core/seeklog.h"
+
+#include "logentry.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <exception>
+#include <stdio.h>
+#include <stdint.h>
+
+// Compiled logs (--compile-log) store parsed entries in columns so they can
+// be replayed without parsing text again:
+//
+//   header     CompiledLogHeader
+//   index      a CompiledLogBlock for every COMPILED_LOG_BLOCK entries
+//   deltas     timestamps as zigzag varint differences from the previous
+//              entry (the first entry of a block from the block timestamp)
+//   sizes      response sizes as varints
+//   times      request times as floats
+//   columns    for each string field a dictionary of its distinct values
+//              (count+1 uint64 offsets followed by the strings), then the
+//              dictionary index of each entry in 1, 2 or 4 bytes
+//
+// Sections start on 8 byte boundaries. Values are in the byte order of the
+// machine that wrote the file; the version doesn't match otherwise.
+
+#define COMPILED_LOG_MAGIC   "LSTALGIA"
+#define COMPILED_LOG_VERSION 1
+
+// entries per seek index block
+#define COMPILED_LOG_BLOCK 1024
+
+enum {
+    COMPILED_LOG_HOSTNAME = 0,
+    COMPILED_LOG_VHOST,
+    COMPILED_LOG_PATH,
+    COMPILED_LOG_PID,
+    COMPILED_LOG_RESPONSE_CODE,
+    COMPILED_LOG_REFERRER,
+    COMPILED_LOG_USER_AGENT,
+    COMPILED_LOG_UPSTREAM,
+    COMPILED_LOG_COLUMNS
+};
+
+struct CompiledLogColumn {
+    uint64_t dictionary_offset;
+    uint64_t values_offset;
+    uint32_t dictionary_count;
+    uint32_t width;
+};
+
+struct CompiledLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_entries;
+    uint64_t entries;
+    uint64_t blocks;
+    uint64_t index_offset;
+    uint64_t deltas_offset;
+    uint64_t deltas_length;
+    uint64_t sizes_offset;
+    uint64_t sizes_length;
+    uint64_t times_offset;
+    CompiledLogColumn columns[COMPILED_LOG_COLUMNS];
+};
+
+struct CompiledLogBlock {
+    int64_t timestamp;
+    uint64_t delta_offset;
+    uint64_t size_offset;
+};
+
+class CompiledLogException : public std::exception {
+protected:
+    std::string message;
+public:
+    CompiledLogException(const std::string& message) : message(message) {}
+    virtual ~CompiledLogException() throw () {};
+
+    virtual const char* what() const throw() { return message.c_str(); }
+};
+
+// Writes entries to a compiled log. Columns are written to temporary files
+// as entries are added and copied into the output by finish(), once the
+// size of each dictionary (and so the width of its indexes) is known.
+
+class LogCompiler {
+    std::string filename;
+    FILE* output;
+
+    FILE* deltas;
+    FILE* sizes;
+    FILE* times;
+    FILE* values[COMPILED_LOG_COLUMNS];
+
+    std::unordered_map<std::string, uint32_t> dictionaries[COMPILED_LOG_COLUMNS];
+    std::vector<const std::string*> dictionary_strings[COMPILED_LOG_COLUMNS];
+
+    std::vector<CompiledLogBlock> index;
+
+    uint64_t entries;
+    uint64_t deltas_length;
+    uint64_t sizes_length;
+    time_t last_timestamp;
+
+    // bytes written to the output
+    uint64_t offset;
+
+    void addValue(int column, const std::string& value);
+
+    void write(const void* buffer, size_t size);
+    uint64_t align();
+    uint64_t copy(FILE* stream);
+    void writeColumn(int column, CompiledLogColumn& column_header);
+    void close();
+public:
+    LogCompiler(const std::string& filename);
+    ~LogCompiler();
+
+    void add(const LogEntry& entry);
+    void finish();
+
+    uint64_t getEntries() const { return entries; };
+};
+
+// Replays a compiled log from memory mapped columns. Each entry is returned
+// by getNextLine() as an empty line, and its fields are read by a
+// CompiledAccessLog when it is parsed.
+
+class CompiledLog : public BaseLog {
+    std::string filename;
+
+    const uint8_t* data;
+    uint64_t length;
+#ifdef _WIN32
+    std::vector<uint8_t> contents;
+#endif
+
+    CompiledLogHeader header;
+    const uint8_t* dictionaries[COMPILED_LOG_COLUMNS];
+    const uint8_t* values[COMPILED_LOG_COLUMNS];
+
+    // hostnames masked once per distinct hostname
+    std::vector<std::string> masked_hostnames;
+
+    // success and colour of each distinct response code
+    std::vector<bool> response_successful;
+    std::vector<vec3> response_colours;
+
+    // next entry returned by getNextLine() and the entry last returned
+    uint64_t position;
+    uint64_t current;
+
+    // the timestamp and size decoders are at the start of this entry
+    uint64_t decoded;
+    const uint8_t* delta_pos;
+    const uint8_t* size_pos;
+    time_t decoded_timestamp;
+
+    void map();
+    void unmap();
+    void validate();
+
+    bool decode(uint64_t entry, time_t& timestamp, uint64_t& size);
+
+    bool readIndex(int column, uint64_t entry, uint32_t& index);
+    void readDictionary(int column, uint32_t index, std::string& value);
+public:
+    CompiledLog(const std::string& filename);
+    ~CompiledLog();
+
+    // true if the file starts with the compiled log magic
+    static bool isCompiledLog(const std::string& filename);
+
+    bool getNextLine(std::string& line);
+    bool isFinished();
+
+    void seekTo(float percent);
+    float getPercent();
+
+    bool getNextLineAt(std::string& line, float percent);
+
+    // reads the fields of the entry last returned
+    bool readEntry(LogEntry& entry);
+
+    uint64_t getEntries() const { return header.entries; };
+};
+
+class CompiledAccessLog : public AccessLog {
+    CompiledLog* log;
+public:
+    CompiledAccessLog(CompiledLog* log);
+
+    bool parseLine(std::string& line, LogEntry& entry);
+};
+
+#endif
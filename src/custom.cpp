@@ -2,6 +2,8 @@
 
 #include "core/regex.h"
 
+#include <algorithm>
+
 //timestamp
 //hostname
 //path
@@ -21,9 +23,14 @@ CustomAccessLog::CustomAccessLog() {
 
 bool CustomAccessLog::parseLine(std::string& line, LogEntry& entry) {
 
+    //at least the five required fields
+    if(std::count(line.begin(), line.end(), '|') < 4) {
+        return reject(PARSE_STAGE_PREFILTER);
+    }
+
     std::vector<std::string> matches;
 
-    if(!custom_entry.match(line, &matches)) return false;
+    if(!custom_entry.match(line, &matches)) return reject(PARSE_STAGE_START);
 
     entry.timestamp = atol(matches[0].c_str());
     entry.hostname  = matches[1];
@@ -79,5 +86,7 @@ bool CustomAccessLog::parseLine(std::string& line, LogEntry& entry) {
         entry.pid = matches[10];
     }
 
-    return entry.validate();
+    if(!entry.validate()) return reject(PARSE_STAGE_VALIDATE);
+
+    return true;
 }
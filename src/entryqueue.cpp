@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "entryqueue.h"
+
+#include <utility>
+
+EntryQueue::EntryQueue() {
+    slots.resize(ENTRY_QUEUE_CAPACITY);
+    head  = 0;
+    count = 0;
+}
+
+void EntryQueue::grow() {
+
+    std::vector<LogEntry> grown(slots.size() * 2);
+
+    for(size_t i=0; i<count; i++) {
+        std::swap(grown[i], slot(i));
+    }
+
+    slots.swap(grown);
+    head = 0;
+}
+
+void EntryQueue::push(const LogEntry& entry) {
+
+    if(count == slots.size()) grow();
+
+    size_t i = count++;
+
+    slot(i) = entry;
+
+    //logs are almost always in order so this rarely moves anything
+    while(i > 0 && slot(i-1).timestamp > slot(i).timestamp) {
+        std::swap(slot(i-1), slot(i));
+        i--;
+    }
+}
+
+void EntryQueue::pop(size_t n) {
+
+    if(n >= count) {
+        clear();
+        return;
+    }
+
+    head   = (head + n) & (slots.size() - 1);
+    count -= n;
+}
+
+void EntryQueue::clear() {
+    head  = 0;
+    count = 0;
+}
+
+size_t EntryQueue::countUntil(time_t time) const {
+
+    //binary search as the entries are in order
+    size_t low  = 0;
+    size_t high = count;
+
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if((*this)[middle].timestamp <= time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
@@ -0,0 +1,65 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_ENTRYQUEUE_H
+#define LOGSTALGIA_ENTRYQUEUE_H
+
+#include "logentry.h"
+
+#include <vector>
+#include <time.h>
+
+// initial number of slots (a power of two)
+#define ENTRY_QUEUE_CAPACITY 1024
+
+// Log entries read but not yet spawned, kept in timestamp order in a ring
+// of slots that is doubled when full. Entries are copied into the slots,
+// which are reused once popped, so the queue doesn't allocate once it has
+// grown to the usual number of entries and their strings have grown to
+// the usual lengths.
+
+class EntryQueue {
+    std::vector<LogEntry> slots;
+    size_t head;
+    size_t count;
+
+    LogEntry& slot(size_t i) { return slots[(head + i) & (slots.size() - 1)]; };
+
+    void grow();
+public:
+    EntryQueue();
+
+    bool empty() const { return count == 0; };
+    size_t size() const { return count; };
+
+    LogEntry& operator[](size_t i) { return slot(i); };
+    const LogEntry& operator[](size_t i) const { return slots[(head + i) & (slots.size() - 1)]; };
+
+    LogEntry& front() { return slot(0); };
+    LogEntry& back()  { return slot(count - 1); };
+
+    // inserts after any entries with the same or an earlier timestamp
+    void push(const LogEntry& entry);
+
+    void pop(size_t n = 1);
+    void clear();
+
+    // number of entries from the front with a timestamp up to and including time
+    size_t countUntil(time_t time) const;
+};
+
+#endif
@@ -0,0 +1,501 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "exporter.h"
+#include "trace.h"
+
+#include "core/logger.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// number of frames in flight on the GPU and waiting for the writer thread
+#define EXPORTER_PIXEL_BUFFERS 3
+#define EXPORTER_FRAMES        4
+
+int exporter_writer_thread(void* exporter) {
+    ((AsyncFrameExporter*) exporter)->writerThread();
+    return 0;
+}
+
+// AsyncFrameExporter
+
+AsyncFrameExporter::AsyncFrameExporter(const std::string& outputfile, int components)
+    : filename(outputfile), components(components) {
+
+    if(filename == "-") {
+        output = &std::cout;
+    } else {
+        output = new std::ofstream(filename.c_str(), std::ios::out | std::ios::binary);
+
+        if(output->fail()) {
+            delete output;
+            throw ExporterException(filename);
+        }
+    }
+
+    width  = display.width;
+    height = display.height;
+
+    pixel_format = (components == 4) ? GL_RGBA : GL_RGB;
+
+    rowstride  = width * components;
+    frame_size = rowstride * height;
+
+    frames.resize(EXPORTER_FRAMES);
+
+    for(char*& frame : frames) {
+        frame = new char[frame_size];
+    }
+
+    frame_read_index  = 0;
+    frame_write_index = 0;
+    frames_queued     = 0;
+    stopping          = false;
+    finished          = false;
+    failed            = false;
+
+    pixel_buffer_index    = 0;
+    pixel_buffers_pending = 0;
+
+    // fall back to synchronous glReadPixels if pixel buffer objects are not available
+    if(GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object) {
+
+        pixel_buffers.resize(EXPORTER_PIXEL_BUFFERS, 0);
+
+        glGenBuffers(EXPORTER_PIXEL_BUFFERS, &(pixel_buffers[0]));
+
+        for(GLuint pbo : pixel_buffers) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frame_size, 0, GL_STREAM_READ);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    mutex         = SDL_CreateMutex();
+    frame_queued  = SDL_CreateCond();
+    frame_written = SDL_CreateCond();
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    thread = SDL_CreateThread(exporter_writer_thread, "frame_exporter", this);
+#else
+    thread = SDL_CreateThread(exporter_writer_thread, this);
+#endif
+}
+
+AsyncFrameExporter::~AsyncFrameExporter() {
+
+    // NOTE: subclasses call finish() in their destructor as writeFrame()
+    // is no longer available here. Only reached unfinished if a subclass
+    // constructor threw, in which case no frames have been queued.
+    if(!finished) {
+        SDL_mutexP(mutex);
+        stopping = true;
+        SDL_CondSignal(frame_queued);
+        SDL_mutexV(mutex);
+
+        SDL_WaitThread(thread, 0);
+    }
+
+    if(!pixel_buffers.empty()) {
+        glDeleteBuffers(pixel_buffers.size(), &(pixel_buffers[0]));
+    }
+
+    for(char* frame : frames) {
+        delete[] frame;
+    }
+    frames.clear();
+
+    SDL_DestroyCond(frame_queued);
+    SDL_DestroyCond(frame_written);
+    SDL_DestroyMutex(mutex);
+
+    if(output != &std::cout) delete output;
+}
+
+// wait for a free frame in the ring (only the render thread writes frames)
+char* AsyncFrameExporter::acquireFrame() {
+
+    SDL_mutexP(mutex);
+
+    while(frames_queued == (int) frames.size()) {
+        SDL_CondWait(frame_written, mutex);
+    }
+
+    char* frame = frames[frame_write_index];
+
+    SDL_mutexV(mutex);
+
+    return frame;
+}
+
+void AsyncFrameExporter::queueFrame() {
+
+    SDL_mutexP(mutex);
+
+    frame_write_index = (frame_write_index + 1) % frames.size();
+    frames_queued++;
+
+    SDL_CondSignal(frame_queued);
+    SDL_mutexV(mutex);
+}
+
+void AsyncFrameExporter::collectPixelBuffer(int index) {
+
+    char* frame = acquireFrame();
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[index]);
+
+    const char* pixels = (const char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+    if(pixels != 0) {
+        memcpy(frame, pixels, frame_size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        errorLog("failed to map pixel buffer");
+        memset(frame, 0, frame_size);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    queueFrame();
+
+    pixel_buffers_pending--;
+}
+
+void AsyncFrameExporter::dump() {
+
+    SDL_mutexP(mutex);
+    bool write_failed = failed;
+    SDL_mutexV(mutex);
+
+    //eg the program reading the stream has exited
+    if(write_failed) throw ExporterException(filename);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if(pixel_buffers.empty()) {
+        char* frame = acquireFrame();
+        glReadPixels(0, 0, width, height, pixel_format, GL_UNSIGNED_BYTE, frame);
+        queueFrame();
+        return;
+    }
+
+    // the next buffer in the ring holds the oldest frame still in flight
+    if(pixel_buffers_pending == (int) pixel_buffers.size()) {
+        collectPixelBuffer(pixel_buffer_index);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[pixel_buffer_index]);
+    glReadPixels(0, 0, width, height, pixel_format, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    pixel_buffer_index = (pixel_buffer_index + 1) % pixel_buffers.size();
+    pixel_buffers_pending++;
+}
+
+// collect any frames still in flight and wait for the writer to catch up
+void AsyncFrameExporter::finish() {
+
+    if(finished) return;
+
+    while(pixel_buffers_pending > 0) {
+        int buffer_count = pixel_buffers.size();
+        int oldest = (pixel_buffer_index - pixel_buffers_pending + buffer_count) % buffer_count;
+        collectPixelBuffer(oldest);
+    }
+
+    SDL_mutexP(mutex);
+    stopping = true;
+    SDL_CondSignal(frame_queued);
+    SDL_mutexV(mutex);
+
+    SDL_WaitThread(thread, 0);
+
+    output->flush();
+
+    finished = true;
+}
+
+void AsyncFrameExporter::writerThread() {
+
+    tracer.nameThread("frame_exporter");
+
+    SDL_mutexP(mutex);
+
+    while(true) {
+
+        while(frames_queued == 0 && !stopping) {
+            SDL_CondWait(frame_queued, mutex);
+        }
+
+        if(frames_queued == 0) break;
+
+        const char* frame = frames[frame_read_index];
+        bool discard      = failed;
+
+        // encode without holding the lock so the render thread can keep queuing
+        SDL_mutexV(mutex);
+
+        bool write_failed = false;
+
+        if(!discard) {
+            TraceScope trace("write frame");
+            writeFrame(frame);
+
+            write_failed = output->fail();
+        }
+
+        SDL_mutexP(mutex);
+
+        if(write_failed) failed = true;
+
+        frame_read_index = (frame_read_index + 1) % frames.size();
+        frames_queued--;
+
+        SDL_CondSignal(frame_written);
+    }
+
+    SDL_mutexV(mutex);
+}
+
+// PPMStreamExporter
+
+PPMStreamExporter::PPMStreamExporter(const std::string& outputfile)
+    : AsyncFrameExporter(outputfile, 3) {
+
+    snprintf(ppmheader, 1024, "P6\n%d %d\n255\n", width, height);
+
+    flipped.resize(frame_size);
+}
+
+PPMStreamExporter::~PPMStreamExporter() {
+    finish();
+}
+
+void PPMStreamExporter::writeFrame(const char* pixels) {
+
+    // PPM rows are stored top to bottom
+    for(int y=0; y<height; y++) {
+        memcpy(&(flipped[y * rowstride]), pixels + (height - y - 1) * rowstride, rowstride);
+    }
+
+    output->write(ppmheader, strlen(ppmheader));
+    output->write(&(flipped[0]), frame_size);
+}
+
+// RawVideoExporter
+
+RawVideoExporter::RawVideoExporter(const std::string& outputfile, int components)
+    : AsyncFrameExporter(outputfile, components) {
+
+    flipped.resize(frame_size);
+}
+
+RawVideoExporter::~RawVideoExporter() {
+    finish();
+}
+
+void RawVideoExporter::writeFrame(const char* pixels) {
+
+    for(int y=0; y<height; y++) {
+        memcpy(&(flipped[y * rowstride]), pixels + (height - y - 1) * rowstride, rowstride);
+    }
+
+    output->write(&(flipped[0]), frame_size);
+}
+
+// Y4MExporter
+
+// BT.601 limited range, 8 bit fixed point
+inline unsigned char exporter_rgb_to_y(int r, int g, int b) {
+    return (( 66*r + 129*g +  25*b + 128) >> 8) +  16;
+}
+
+inline unsigned char exporter_rgb_to_u(int r, int g, int b) {
+    return ((-38*r -  74*g + 112*b + 128) >> 8) + 128;
+}
+
+inline unsigned char exporter_rgb_to_v(int r, int g, int b) {
+    return ((112*r -  94*g -  18*b + 128) >> 8) + 128;
+}
+
+#ifdef __SSE2__
+// split 8 RGBA pixels into 16 bit R, G and B lanes
+inline void exporter_unpack_rgba(const unsigned char* rgba, __m128i& r, __m128i& g, __m128i& b) {
+
+    const __m128i mask = _mm_set1_epi32(0xFF);
+
+    __m128i p0 = _mm_loadu_si128((const __m128i*) rgba);
+    __m128i p1 = _mm_loadu_si128((const __m128i*) (rgba + 16));
+
+    r = _mm_packs_epi32(_mm_and_si128(p0, mask),                   _mm_and_si128(p1, mask));
+    g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),  _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+    b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask), _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+// luma of 8 pixels (the weighted sum fits in an unsigned 16 bit lane)
+inline __m128i exporter_luma(const __m128i& r, const __m128i& g, const __m128i& b) {
+
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    y = _mm_add_epi16(y, _mm_set1_epi16(128));
+
+    return _mm_add_epi16(_mm_srli_epi16(y, 8), _mm_set1_epi16(16));
+}
+
+// average 2x2 blocks of two rows of 8 values down to 4 values
+inline __m128i exporter_average_2x2(const __m128i& row0, const __m128i& row1) {
+
+    __m128i sum = _mm_madd_epi16(_mm_add_epi16(row0, row1), _mm_set1_epi16(1));
+    sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(2)), 2);
+
+    return _mm_packs_epi32(sum, sum);
+}
+
+inline __m128i exporter_chroma(const __m128i& r, const __m128i& g, const __m128i& b, short cr, short cg, short cb) {
+
+    __m128i c = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+    c = _mm_add_epi16(c, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+    c = _mm_add_epi16(c, _mm_set1_epi16(128));
+
+    return _mm_add_epi16(_mm_srai_epi16(c, 8), _mm_set1_epi16(128));
+}
+#endif
+
+Y4MExporter::Y4MExporter(const std::string& outputfile, int framerate)
+    : AsyncFrameExporter(outputfile, 4) {
+
+    chroma_width  = (width  + 1) / 2;
+    chroma_height = (height + 1) / 2;
+
+    yuv.resize(width * height + chroma_width * chroma_height * 2);
+
+    char header[256];
+    snprintf(header, 256, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n", width, height, framerate);
+
+    output->write(header, strlen(header));
+
+    if(output->fail()) throw ExporterException(filename);
+}
+
+Y4MExporter::~Y4MExporter() {
+    finish();
+}
+
+// convert a pair of RGBA rows into two rows of luma and one row of each chroma plane
+// (y1 is null and row1 repeats row0 for the last row of an odd height frame)
+void Y4MExporter::convertRows(const unsigned char* row0, const unsigned char* row1,
+                              unsigned char* y0, unsigned char* y1,
+                              unsigned char* u, unsigned char* v) {
+    int x = 0;
+
+#ifdef __SSE2__
+    for(; x + 8 <= width; x += 8) {
+
+        __m128i r0, g0, b0, r1, g1, b1;
+
+        exporter_unpack_rgba(row0 + x * 4, r0, g0, b0);
+        exporter_unpack_rgba(row1 + x * 4, r1, g1, b1);
+
+        __m128i l0 = exporter_luma(r0, g0, b0);
+        _mm_storel_epi64((__m128i*) (y0 + x), _mm_packus_epi16(l0, l0));
+
+        if(y1 != 0) {
+            __m128i l1 = exporter_luma(r1, g1, b1);
+            _mm_storel_epi64((__m128i*) (y1 + x), _mm_packus_epi16(l1, l1));
+        }
+
+        __m128i r = exporter_average_2x2(r0, r1);
+        __m128i g = exporter_average_2x2(g0, g1);
+        __m128i b = exporter_average_2x2(b0, b1);
+
+        __m128i cu = exporter_chroma(r, g, b, -38, -74, 112);
+        __m128i cv = exporter_chroma(r, g, b, 112, -94, -18);
+
+        int u4 = _mm_cvtsi128_si32(_mm_packus_epi16(cu, cu));
+        int v4 = _mm_cvtsi128_si32(_mm_packus_epi16(cv, cv));
+
+        memcpy(u + x / 2, &u4, 4);
+        memcpy(v + x / 2, &v4, 4);
+    }
+#endif
+
+    for(; x < width; x += 2) {
+
+        // repeat the last column of an odd width frame
+        int x1 = std::min(x + 1, width - 1);
+
+        const unsigned char* p00 = row0 + x * 4;
+        const unsigned char* p01 = row0 + x1 * 4;
+        const unsigned char* p10 = row1 + x * 4;
+        const unsigned char* p11 = row1 + x1 * 4;
+
+        y0[x] = exporter_rgb_to_y(p00[0], p00[1], p00[2]);
+        if(x1 != x) y0[x1] = exporter_rgb_to_y(p01[0], p01[1], p01[2]);
+
+        if(y1 != 0) {
+            y1[x] = exporter_rgb_to_y(p10[0], p10[1], p10[2]);
+            if(x1 != x) y1[x1] = exporter_rgb_to_y(p11[0], p11[1], p11[2]);
+        }
+
+        int r = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+        int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+        int b = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+
+        u[x/2] = exporter_rgb_to_u(r, g, b);
+        v[x/2] = exporter_rgb_to_v(r, g, b);
+    }
+}
+
+void Y4MExporter::writeFrame(const char* pixels) {
+
+    unsigned char* y_plane = &(yuv[0]);
+    unsigned char* u_plane = y_plane + width * height;
+    unsigned char* v_plane = u_plane + chroma_width * chroma_height;
+
+    const unsigned char* rgba = (const unsigned char*) pixels;
+
+    for(int cy=0; cy < chroma_height; cy++) {
+
+        int y = cy * 2;
+
+        // frame is bottom row first
+        const unsigned char* row0 = rgba + (height - y - 1) * rowstride;
+        const unsigned char* row1 = row0;
+
+        unsigned char* y0 = y_plane + y * width;
+        unsigned char* y1 = 0;
+
+        if(y + 1 < height) {
+            row1 = rgba + (height - y - 2) * rowstride;
+            y1   = y0 + width;
+        }
+
+        convertRows(row0, row1, y0, y1, u_plane + cy * chroma_width, v_plane + cy * chroma_width);
+    }
+
+    output->write("FRAME\n", 6);
+    output->write((const char*) &(yuv[0]), yuv.size());
+}
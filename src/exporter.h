@@ -0,0 +1,136 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_EXPORTER_H
+#define LOGSTALGIA_EXPORTER_H
+
+#include "core/display.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <exception>
+
+class ExporterException : public std::exception {
+protected:
+    std::string filename;
+public:
+    ExporterException(const std::string& filename) : filename(filename) {}
+    virtual ~ExporterException() throw () {};
+
+    virtual const char* what() const throw() { return filename.c_str(); }
+};
+
+// Pipelined frame exporter.
+//
+// dump() starts an asynchronous read of the current frame into a ring of
+// pixel buffer objects and collects the frame issued pixel_buffer_count
+// frames earlier, so the GPU copy overlaps with rendering the next frames.
+// Collected frames are queued in a ring of frame buffers and encoded by a
+// dedicated writer thread. The queue blocks when full so no frame is dropped.
+//
+// Frames are passed to writeFrame() bottom row first, as read by glReadPixels.
+
+class AsyncFrameExporter {
+
+    SDL_Thread* thread;
+    SDL_mutex*  mutex;
+    SDL_cond*   frame_queued;
+    SDL_cond*   frame_written;
+
+    std::vector<char*> frames;
+    int  frame_read_index;
+    int  frame_write_index;
+    int  frames_queued;
+    bool stopping;
+    bool finished;
+
+    // the output could not be written to, queued frames are discarded
+    bool failed;
+
+    std::vector<GLuint> pixel_buffers;
+    int pixel_buffer_index;
+    int pixel_buffers_pending;
+
+    char* acquireFrame();
+    void queueFrame();
+
+    void collectPixelBuffer(int index);
+protected:
+    std::ostream* output;
+    std::string   filename;
+
+    int    width;
+    int    height;
+    int    components;
+    GLenum pixel_format;
+
+    size_t rowstride;
+    size_t frame_size;
+
+    virtual void writeFrame(const char* pixels) = 0;
+public:
+    AsyncFrameExporter(const std::string& outputfile, int components = 3);
+    virtual ~AsyncFrameExporter();
+
+    // throws an ExporterException once the output can't be written to
+    void dump();
+    void finish();
+
+    void writerThread();
+};
+
+class PPMStreamExporter : public AsyncFrameExporter {
+    char ppmheader[1024];
+    std::vector<char> flipped;
+protected:
+    void writeFrame(const char* pixels);
+public:
+    PPMStreamExporter(const std::string& outputfile);
+    ~PPMStreamExporter();
+};
+
+// headerless packed rgb24 or rgba frames (eg ffmpeg -f rawvideo -pix_fmt rgb24)
+
+class RawVideoExporter : public AsyncFrameExporter {
+    std::vector<char> flipped;
+protected:
+    void writeFrame(const char* pixels);
+public:
+    RawVideoExporter(const std::string& outputfile, int components);
+    ~RawVideoExporter();
+};
+
+// YUV4MPEG2 stream of I420 frames, converted from RGBA on the writer thread
+
+class Y4MExporter : public AsyncFrameExporter {
+    int chroma_width;
+    int chroma_height;
+
+    std::vector<unsigned char> yuv;
+
+    void convertRows(const unsigned char* row0, const unsigned char* row1,
+                     unsigned char* y0, unsigned char* y1,
+                     unsigned char* u, unsigned char* v);
+protected:
+    void writeFrame(const char* pixels);
+public:
+    Y4MExporter(const std::string& outputfile, int framerate);
+    ~Y4MExporter();
+};
+
+#endif
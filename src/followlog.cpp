@@ -0,0 +1,370 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "followlog.h"
+
+#include "core/logger.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#define follow_fseek _fseeki64
+#else
+#define follow_fseek fseeko
+#endif
+
+FollowLog::FollowLog(const std::string& logfile, bool from_end) {
+
+    this->logfile = logfile;
+
+    size_t slash = logfile.find_last_of("/\\");
+
+    std::string directory;
+
+    if(slash == std::string::npos) {
+        basename  = logfile;
+        directory = ".";
+    } else {
+        basename  = logfile.substr(slash+1);
+        directory = (slash == 0) ? "/" : logfile.substr(0, slash);
+    }
+
+    file        = 0;
+    file_dev    = 0;
+    file_ino    = 0;
+    file_offset = 0;
+    file_size   = 0;
+    line_offset = 0;
+
+    buffer_pos   = 0;
+    skip_partial = false;
+    data_pending = false;
+
+    inotify_fd = -1;
+    last_poll  = 0;
+
+    if(!openFile()) throw SeekLogException(logfile);
+
+    //start at the live end like tail
+    if(from_end) {
+        follow_fseek(file, file_size, SEEK_SET);
+        file_offset = line_offset = file_size;
+    }
+
+#ifdef __linux__
+    //watch the directory rather than the file to see it being replaced
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if(inotify_fd >= 0) {
+        if(inotify_add_watch(inotify_fd, directory.c_str(),
+                             IN_MODIFY | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB) < 0) {
+            close(inotify_fd);
+            inotify_fd = -1;
+        }
+    }
+#endif
+
+    if(inotify_fd < 0) debugLog("polling %s for changes", logfile.c_str());
+}
+
+FollowLog::~FollowLog() {
+    closeFile();
+
+#ifdef __linux__
+    if(inotify_fd >= 0) close(inotify_fd);
+#endif
+}
+
+bool FollowLog::openFile() {
+
+    FILE* f = fopen(logfile.c_str(), "rb");
+
+    if(f == 0) return false;
+
+    struct stat finfo;
+
+    if(fstat(fileno(f), &finfo) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    //reads are already done in large chunks
+    setvbuf(f, 0, _IONBF, 0);
+
+    file        = f;
+    file_dev    = finfo.st_dev;
+    file_ino    = finfo.st_ino;
+    file_size   = finfo.st_size;
+    file_offset = 0;
+    line_offset = 0;
+
+    buffer.clear();
+    buffer_pos   = 0;
+    skip_partial = false;
+    data_pending = true;
+
+    return true;
+}
+
+void FollowLog::closeFile() {
+    if(file != 0) {
+        fclose(file);
+        file = 0;
+    }
+}
+
+// reads the next chunk of the file, returns false if there was nothing new
+bool FollowLog::fill() {
+
+    if(file == 0) return false;
+
+    //drop lines already returned
+    if(buffer_pos > 0) {
+        buffer.erase(0, buffer_pos);
+        buffer_pos = 0;
+    }
+
+    size_t buffered = buffer.size();
+
+    buffer.resize(buffered + FOLLOW_LOG_CHUNK);
+
+    clearerr(file);
+    size_t bytes = fread(&(buffer[buffered]), 1, FOLLOW_LOG_CHUNK, file);
+
+    buffer.resize(buffered + bytes);
+
+    file_offset += bytes;
+    if(file_offset > file_size) file_size = file_offset;
+
+    return bytes > 0;
+}
+
+bool FollowLog::bufferedLine(std::string& line) {
+
+    while(buffer_pos < buffer.size()) {
+
+        const char* start = buffer.data() + buffer_pos;
+        const char* eol   = (const char*) memchr(start, '\n', buffer.size() - buffer_pos);
+
+        //wait for the rest of the line to be written
+        if(eol == 0) return false;
+
+        size_t length = eol - start;
+
+        buffer_pos  += length + 1;
+        line_offset += length + 1;
+
+        //the remainder of a line cut by seeking
+        if(skip_partial) {
+            skip_partial = false;
+            continue;
+        }
+
+        line.assign(start, length);
+
+        return true;
+    }
+
+    return false;
+}
+
+// checks for changes to the file, returns true if there may be more to read
+bool FollowLog::pollChanges() {
+
+#ifdef __linux__
+    if(inotify_fd >= 0) {
+
+        bool check = false;
+
+        char events[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        ssize_t bytes;
+
+        while((bytes = read(inotify_fd, events, sizeof(events))) > 0) {
+
+            for(char* p = events; p < events + bytes; ) {
+                struct inotify_event* event = (struct inotify_event*) p;
+
+                if(event->mask & IN_Q_OVERFLOW) {
+                    check = true;
+                } else if(event->len > 0 && basename == event->name) {
+                    //modifications are checked too as a truncation only reports IN_MODIFY
+                    check = true;
+                }
+
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+        if(check) checkFile();
+
+        return data_pending;
+    }
+#endif
+
+    Uint32 now = SDL_GetTicks();
+
+    if(last_poll != 0 && now - last_poll < FOLLOW_LOG_POLL_INTERVAL) return false;
+
+    last_poll = now;
+
+    checkFile();
+
+    return data_pending;
+}
+
+// detects the file growing, being truncated or being replaced by a new file
+bool FollowLog::checkFile() {
+
+    struct stat finfo;
+
+    //moved away and not recreated yet
+    if(stat(logfile.c_str(), &finfo) != 0) return false;
+
+    if((unsigned long long) finfo.st_dev != file_dev || (unsigned long long) finfo.st_ino != file_ino) {
+
+        //finish reading the old file first
+        while(fill());
+
+        std::string remainder = buffer.substr(buffer_pos);
+
+        if(!remainder.empty() && remainder[remainder.size()-1] != '\n') remainder += '\n';
+
+        closeFile();
+
+        if(!openFile()) {
+            debugLog("could not reopen %s", logfile.c_str());
+            return false;
+        }
+
+        debugLog("%s was replaced, reopened", logfile.c_str());
+
+        //lines left over from the old file are returned first
+        buffer      = remainder;
+        line_offset = -(long long) remainder.size();
+
+        return true;
+    }
+
+    if(finfo.st_size < file_offset) {
+
+        debugLog("%s was truncated, reading from the start", logfile.c_str());
+
+        follow_fseek(file, 0, SEEK_SET);
+
+        file_offset = line_offset = 0;
+        file_size   = finfo.st_size;
+
+        buffer.clear();
+        buffer_pos   = 0;
+        skip_partial = false;
+        data_pending = true;
+
+        return true;
+    }
+
+    file_size = finfo.st_size;
+
+    if(file_size > file_offset) data_pending = true;
+
+    return data_pending;
+}
+
+bool FollowLog::getNextLine(std::string& line) {
+
+    while(true) {
+
+        if(bufferedLine(line)) return true;
+
+        if(data_pending && fill()) continue;
+
+        data_pending = false;
+
+        if(!pollChanges()) return false;
+    }
+}
+
+bool FollowLog::isFinished() {
+    return false;
+}
+
+void FollowLog::seekTo(float percent) {
+
+    if(file == 0) return;
+
+    long long position = (long long) (file_size * (double) percent);
+
+    follow_fseek(file, position, SEEK_SET);
+
+    file_offset = line_offset = position;
+
+    buffer.clear();
+    buffer_pos   = 0;
+    skip_partial = position > 0;
+    data_pending = true;
+}
+
+float FollowLog::getPercent() {
+
+    if(file_size <= 0 || line_offset <= 0) return 0.0f;
+
+    if(line_offset >= file_size) return 1.0f;
+
+    return (float) ((double) line_offset / (double) file_size);
+}
+
+// the first complete line after a position, without moving the read position
+bool FollowLog::getNextLineAt(std::string& line, float percent) {
+
+    if(file == 0) return false;
+
+    long long position = (long long) (file_size * (double) percent);
+
+    char chunk[8192];
+
+    follow_fseek(file, position, SEEK_SET);
+
+    clearerr(file);
+    size_t bytes = fread(chunk, 1, sizeof(chunk), file);
+
+    follow_fseek(file, file_offset, SEEK_SET);
+
+    const char* p   = chunk;
+    const char* end = chunk + bytes;
+
+    if(position > 0) {
+        const char* eol = (const char*) memchr(p, '\n', end - p);
+
+        if(eol == 0) return false;
+
+        p = eol + 1;
+    }
+
+    const char* eol = (const char*) memchr(p, '\n', end - p);
+
+    if(eol == 0) return false;
+
+    line.assign(p, eol - p);
+
+    return true;
+}
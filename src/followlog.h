@@ -0,0 +1,83 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_FOLLOWLOG_H
+#define LOGSTALGIA_FOLLOWLOG_H
+
+#include "core/seeklog.h"
+
+#include <string>
+#include <stdio.h>
+
+// bytes read from the file at a time
+#define FOLLOW_LOG_CHUNK 65536
+
+// milliseconds between checks of the file when inotify is not available
+#define FOLLOW_LOG_POLL_INTERVAL 250
+
+// Reads a log file as it is written to, like 'tail -F'. New data is read
+// in large chunks only when inotify (or polling the file's size where
+// inotify isn't available) reports the file has grown. The file is
+// reopened when rotated and read from the start again when truncated.
+// Earlier parts of the file can still be sought to by percentage.
+
+class FollowLog : public BaseLog {
+    std::string logfile;
+    std::string basename;
+
+    FILE* file;
+    unsigned long long file_dev;
+    unsigned long long file_ino;
+
+    // offset the next read from the file starts at
+    long long file_offset;
+    long long file_size;
+
+    // offset in the file of the next line returned
+    long long line_offset;
+
+    std::string buffer;
+    size_t buffer_pos;
+    bool skip_partial;
+
+    bool data_pending;
+
+    int inotify_fd;
+    Uint32 last_poll;
+
+    bool openFile();
+    void closeFile();
+
+    bool fill();
+    bool bufferedLine(std::string& line);
+
+    bool pollChanges();
+    bool checkFile();
+public:
+    FollowLog(const std::string& logfile, bool from_end);
+    ~FollowLog();
+
+    bool getNextLine(std::string& line);
+    bool isFinished();
+
+    void seekTo(float percent);
+    float getPercent();
+
+    bool getNextLineAt(std::string& line, float percent);
+};
+
+#endif
@@ -0,0 +1,662 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "formatlog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+extern const char* ls_ncsa_months[];
+
+// well known format names
+const char* format_log_nicknames[][2] = {
+    { "common",         "%h %l %u %t \"%r\" %>s %b" },
+    { "combined",       "%h %l %u %t \"%r\" %>s %b \"%{Referer}i\" \"%{User-agent}i\"" },
+    { "vhost_combined", "%v:%p %h %l %u %t \"%r\" %>s %O \"%{Referer}i\" \"%{User-Agent}i\"" },
+    { 0, 0 }
+};
+
+// nginx variables that map to entry fields, other variables are skipped
+struct FormatVariable {
+    const char* name;
+    int field;
+};
+
+const FormatVariable format_log_nginx_variables[] = {
+    { "remote_addr",        FORMAT_FIELD_HOSTNAME    },
+    { "realip_remote_addr", FORMAT_FIELD_HOSTNAME    },
+    { "host",               FORMAT_FIELD_VHOST       },
+    { "http_host",          FORMAT_FIELD_VHOST       },
+    { "server_name",        FORMAT_FIELD_VHOST       },
+    { "time_local",         FORMAT_FIELD_TIME_CLF    },
+    { "time_iso8601",       FORMAT_FIELD_TIME_ISO8601 },
+    { "msec",               FORMAT_FIELD_TIME_SEC    },
+    { "request",            FORMAT_FIELD_REQUEST     },
+    { "request_uri",        FORMAT_FIELD_PATH        },
+    { "uri",                FORMAT_FIELD_PATH        },
+    { "document_uri",       FORMAT_FIELD_PATH        },
+    { "args",               FORMAT_FIELD_ARGS        },
+    { "query_string",       FORMAT_FIELD_ARGS        },
+    { "status",             FORMAT_FIELD_STATUS      },
+    { "body_bytes_sent",    FORMAT_FIELD_SIZE        },
+    { "bytes_sent",         FORMAT_FIELD_SIZE        },
+    { "http_referer",       FORMAT_FIELD_REFERRER    },
+    { "http_user_agent",    FORMAT_FIELD_USER_AGENT  },
+    { "pid",                FORMAT_FIELD_PID         },
+    { "request_time",       FORMAT_FIELD_REQUEST_SEC },
+    { "upstream_addr",      FORMAT_FIELD_UPSTREAM    },
+    { 0, 0 }
+};
+
+// reads an unsigned integer of at least one digit
+bool format_log_read_int(const char*& p, const char* end, int& value) {
+
+    if(p >= end || !isdigit((unsigned char)*p)) return false;
+
+    value = 0;
+
+    while(p < end && isdigit((unsigned char)*p)) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+
+    return true;
+}
+
+bool format_log_expect(const char*& p, const char* end, char c) {
+    if(p >= end || *p != c) return false;
+    p++;
+    return true;
+}
+
+// reads a +hhmm or +hh:mm offset from utc
+bool format_log_read_zone(const char*& p, const char* end, int& tz_offset) {
+
+    tz_offset = 0;
+
+    if(p >= end) return true;
+
+    if(*p == 'Z') {
+        p++;
+        return true;
+    }
+
+    if(*p != '+' && *p != '-') return false;
+
+    bool negative = *p == '-';
+    p++;
+
+    if(end - p < 4) return false;
+
+    int tz_hour = 0, tz_min = 0;
+
+    for(int i=0; i<2; i++) {
+        if(!isdigit((unsigned char)*p)) return false;
+        tz_hour = tz_hour * 10 + (*p++ - '0');
+    }
+
+    if(*p == ':') p++;
+
+    for(int i=0; i<2 && p < end; i++) {
+        if(!isdigit((unsigned char)*p)) return false;
+        tz_min = tz_min * 10 + (*p++ - '0');
+    }
+
+    tz_offset = tz_hour * 3600 + tz_min * 60;
+
+    if(negative) tz_offset = -tz_offset;
+
+    return true;
+}
+
+// seconds since the epoch of a UTC date. equivalent to mktime() while the
+// time zone is set to UTC by readLog, without the cost of a time zone lookup
+time_t format_log_make_time(int year, int month, int day, int hour, int minute, int second, int tz_offset) {
+
+    //days from civil (month 0-11)
+    int y = (month < 2) ? year - 1 : year;
+    int m = month + 1;
+
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = era * 146097 + doe - 719468;
+
+    return (time_t) days * 86400 + hour * 3600 + minute * 60 + second - tz_offset;
+}
+
+// 10/Oct/2000:13:55:36 -0700, optionally inside []
+bool format_log_parse_clf_time(const char* p, const char* end, time_t& timestamp) {
+
+    if(p < end && *p == '[') p++;
+    if(p < end && *(end-1) == ']') end--;
+
+    int day, month = -1, year, hour, minute, second, tz_offset;
+
+    if(!format_log_read_int(p, end, day) || !format_log_expect(p, end, '/')) return false;
+
+    if(p < end && isdigit((unsigned char)*p)) {
+        if(!format_log_read_int(p, end, month)) return false;
+        month--;
+    } else {
+        if(end - p < 3) return false;
+
+        for(int i=0;i<12;i++) {
+            if(strncmp(p, ls_ncsa_months[i], 3)==0) {
+                month = i;
+                break;
+            }
+        }
+        p += 3;
+    }
+
+    if(month<0 || month>11) return false;
+
+    if(   !format_log_expect(p, end, '/')
+       || !format_log_read_int(p, end, year)   || !format_log_expect(p, end, ':')
+       || !format_log_read_int(p, end, hour)   || !format_log_expect(p, end, ':')
+       || !format_log_read_int(p, end, minute) || !format_log_expect(p, end, ':')
+       || !format_log_read_int(p, end, second)) return false;
+
+    while(p < end && *p == ' ') p++;
+
+    if(!format_log_read_zone(p, end, tz_offset)) return false;
+
+    timestamp = format_log_make_time(year, month, day, hour, minute, second, tz_offset);
+
+    return true;
+}
+
+// 2000-10-10T13:55:36-07:00
+bool format_log_parse_iso8601_time(const char* p, const char* end, time_t& timestamp) {
+
+    int year, month, day, hour, minute, second, tz_offset;
+
+    if(   !format_log_read_int(p, end, year)   || !format_log_expect(p, end, '-')
+       || !format_log_read_int(p, end, month)  || !format_log_expect(p, end, '-')
+       || !format_log_read_int(p, end, day)) return false;
+
+    if(p >= end || (*p != 'T' && *p != ' ')) return false;
+    p++;
+
+    if(   !format_log_read_int(p, end, hour)   || !format_log_expect(p, end, ':')
+       || !format_log_read_int(p, end, minute) || !format_log_expect(p, end, ':')
+       || !format_log_read_int(p, end, second)) return false;
+
+    //skip fractional seconds
+    if(p < end && *p == '.') {
+        p++;
+        while(p < end && isdigit((unsigned char)*p)) p++;
+    }
+
+    if(month<1 || month>12) return false;
+
+    if(!format_log_read_zone(p, end, tz_offset)) return false;
+
+    timestamp = format_log_make_time(year, month-1, day, hour, minute, second, tz_offset);
+
+    return true;
+}
+
+// path of a 'METHOD PATH PROTOCOL' request line
+void format_log_request_path(const char* p, const char* end, std::string& path) {
+
+    const char* path_start = (const char*) memchr(p, ' ', end - p);
+    const char* path_end   = 0;
+
+    if(path_start != 0) {
+        while(path_start < end && *path_start == ' ') path_start++;
+        path_end = (const char*) memchr(path_start, ' ', end - path_start);
+    }
+
+    if(path_end != 0 && path_end > path_start) {
+        path.assign(path_start, path_end - path_start);
+    } else {
+        path = "???";
+    }
+}
+
+// matches a literal, where a space matches any run of spaces
+bool format_log_match_literal(const char*& p, const char* end, const std::string& literal) {
+
+    for(size_t i=0; i<literal.size(); i++) {
+
+        if(p >= end) return false;
+
+        if(literal[i] == ' ') {
+            if(*p != ' ') return false;
+
+            while(p < end && *p == ' ') p++;
+            while(i+1 < literal.size() && literal[i+1] == ' ') i++;
+            continue;
+        }
+
+        if(*p != literal[i]) return false;
+        p++;
+    }
+
+    return true;
+}
+
+FormatLog::FormatLog(const std::string& format) {
+
+    min_length = 0;
+
+    std::string expanded = format;
+
+    for(int i=0; format_log_nicknames[i][0] != 0; i++) {
+        if(format == format_log_nicknames[i][0]) {
+            expanded = format_log_nicknames[i][1];
+            break;
+        }
+    }
+
+    if(!compile(expanded)) {
+        steps.clear();
+        if(error.empty()) error = "invalid log format";
+    }
+}
+
+void FormatLog::addLiteral(const std::string& literal) {
+    if(literal.empty()) return;
+
+    FormatStep step;
+    step.field      = FORMAT_FIELD_LITERAL;
+    step.literal    = literal;
+    step.terminator = '\0';
+
+    steps.push_back(step);
+
+    min_length += literal.size();
+}
+
+void FormatLog::addField(int field) {
+    FormatStep step;
+    step.field      = field;
+    step.terminator = '\0';
+
+    steps.push_back(step);
+}
+
+bool FormatLog::compile(const std::string& format) {
+
+    std::string literal;
+
+    for(size_t i=0; i<format.size(); i++) {
+
+        char c = format[i];
+        char next = (i+1 < format.size()) ? format[i+1] : '\0';
+
+        //escapes as written in Apache and nginx configuration files
+        if(c == '\\' && next != '\0') {
+            switch(next) {
+                case 'n':
+                    literal += '\n';
+                    break;
+                case 't':
+                    literal += '\t';
+                    break;
+                default:
+                    literal += next;
+                    break;
+            }
+            i++;
+            continue;
+        }
+
+        if(c == '%') {
+            if(next == '%') {
+                literal += '%';
+                i++;
+                continue;
+            }
+
+            addLiteral(literal);
+            literal.clear();
+
+            if(!compileApacheDirective(format, i)) return false;
+            continue;
+        }
+
+        if(c == '$' && (next == '{' || next == '_' || isalpha((unsigned char)next))) {
+
+            addLiteral(literal);
+            literal.clear();
+
+            if(!compileNginxVariable(format, i)) return false;
+            continue;
+        }
+
+        literal += c;
+    }
+
+    addLiteral(literal);
+
+    if(steps.empty()) {
+        error = "empty log format";
+        return false;
+    }
+
+    //fields extend to the first character of the following literal
+    for(size_t i=0; i<steps.size(); i++) {
+
+        if(steps[i].field == FORMAT_FIELD_LITERAL) continue;
+
+        //fields not used directly after another field are read as part of it,
+        //and %U%q or $uri$is_args$args as a single path including the query string
+        while(i+1 < steps.size()) {
+
+            int next = steps[i+1].field;
+
+            if(   next != FORMAT_FIELD_IGNORE
+               && !(steps[i].field == FORMAT_FIELD_PATH && (next == FORMAT_FIELD_QUERY || next == FORMAT_FIELD_ARGS))) break;
+
+            steps.erase(steps.begin() + i + 1);
+        }
+
+        if(i+1 < steps.size()) {
+            if(steps[i+1].field != FORMAT_FIELD_LITERAL) {
+                error = "log format fields must be separated by a delimiter";
+                return false;
+            }
+
+            steps[i].terminator = steps[i+1].literal[0];
+        }
+    }
+
+    return true;
+}
+
+// %[modifiers][{param}]directive
+bool FormatLog::compileApacheDirective(const std::string& format, size_t& i) {
+
+    size_t j = i + 1;
+
+    //conditions (%400,501{User-agent}i) and original/final request (%>s)
+    while(j < format.size() && strchr("<>!,0123456789", format[j]) != 0) j++;
+
+    std::string param;
+
+    if(j < format.size() && format[j] == '{') {
+        size_t close = format.find('}', j);
+
+        if(close == std::string::npos) {
+            error = "unterminated log format directive";
+            return false;
+        }
+
+        param = format.substr(j+1, close-j-1);
+        j = close + 1;
+    }
+
+    if(j >= format.size() || !isalpha((unsigned char)format[j])) {
+        error = "invalid log format directive at '" + format.substr(i) + "'";
+        return false;
+    }
+
+    for(size_t k=0; k<param.size(); k++) {
+        param[k] = tolower((unsigned char)param[k]);
+    }
+
+    int field = FORMAT_FIELD_IGNORE;
+
+    switch(format[j]) {
+        case 'h':
+        case 'a':
+            field = FORMAT_FIELD_HOSTNAME;
+            break;
+        case 'v':
+        case 'V':
+            field = FORMAT_FIELD_VHOST;
+            break;
+        case 't':
+            if(param.empty())        field = FORMAT_FIELD_TIME_CLF;
+            else if(param == "sec")  field = FORMAT_FIELD_TIME_SEC;
+            else if(param == "msec") field = FORMAT_FIELD_TIME_MSEC;
+            else if(param == "usec") field = FORMAT_FIELD_TIME_USEC;
+            else {
+                error = "unsupported time format %{" + param + "}t";
+                return false;
+            }
+            break;
+        case 'r':
+            field = FORMAT_FIELD_REQUEST;
+            break;
+        case 'U':
+            field = FORMAT_FIELD_PATH;
+            break;
+        case 'q':
+            field = FORMAT_FIELD_QUERY;
+            break;
+        case 's':
+            field = FORMAT_FIELD_STATUS;
+            break;
+        case 'b':
+        case 'B':
+        case 'O':
+            field = FORMAT_FIELD_SIZE;
+            break;
+        case 'i':
+            if(param == "referer")         field = FORMAT_FIELD_REFERRER;
+            else if(param == "user-agent") field = FORMAT_FIELD_USER_AGENT;
+            break;
+        case 'P':
+            field = FORMAT_FIELD_PID;
+            break;
+        case 'D':
+            field = FORMAT_FIELD_REQUEST_USEC;
+            break;
+        case 'T':
+            if(param.empty() || param == "s") field = FORMAT_FIELD_REQUEST_SEC;
+            else if(param == "ms")            field = FORMAT_FIELD_REQUEST_MSEC;
+            else if(param == "us")            field = FORMAT_FIELD_REQUEST_USEC;
+            break;
+        default:
+            break;
+    }
+
+    addField(field);
+
+    i = j;
+
+    return true;
+}
+
+// $variable or ${variable}
+bool FormatLog::compileNginxVariable(const std::string& format, size_t& i) {
+
+    std::string name;
+    size_t j = i + 1;
+
+    if(format[j] == '{') {
+        size_t close = format.find('}', j);
+
+        if(close == std::string::npos) {
+            error = "unterminated log format variable";
+            return false;
+        }
+
+        name = format.substr(j+1, close-j-1);
+        j = close;
+    } else {
+        while(j < format.size() && (format[j] == '_' || isalnum((unsigned char)format[j]))) j++;
+
+        name = format.substr(i+1, j-i-1);
+        j--;
+    }
+
+    int field = FORMAT_FIELD_IGNORE;
+
+    for(int k=0; format_log_nginx_variables[k].name != 0; k++) {
+        if(name == format_log_nginx_variables[k].name) {
+            field = format_log_nginx_variables[k].field;
+            break;
+        }
+    }
+
+    addField(field);
+
+    i = j;
+
+    return true;
+}
+
+bool FormatLog::parseLine(std::string& line, LogEntry& entry) {
+
+    if(steps.empty() || line.size() < min_length) {
+        return reject(PARSE_STAGE_PREFILTER);
+    }
+
+    const char* p   = line.c_str();
+    const char* end = p + line.size();
+
+    std::string query;
+
+    for(const FormatStep& step : steps) {
+
+        if(step.field == FORMAT_FIELD_LITERAL) {
+            if(!format_log_match_literal(p, end, step.literal)) return reject(PARSE_STAGE_START);
+            continue;
+        }
+
+        const char* value     = p;
+        const char* value_end = end;
+
+        if(step.field == FORMAT_FIELD_TIME_CLF && p < end && *p == '[') {
+
+            //Apache's %t includes the brackets and a space
+            value_end = (const char*) memchr(p, ']', end - p);
+
+            if(value_end == 0) return reject(PARSE_STAGE_DATE);
+
+            value_end++;
+
+        } else if(step.terminator == '"') {
+
+            //quoted values may contain escaped quotes
+            value_end = p;
+
+            while(value_end < end && *value_end != '"') {
+                if(*value_end == '\\' && value_end+1 < end) value_end++;
+                value_end++;
+            }
+
+            if(value_end >= end) return reject(PARSE_STAGE_START);
+
+        } else if(step.terminator != '\0') {
+
+            value_end = (const char*) memchr(p, step.terminator, end - p);
+
+            if(value_end == 0) return reject(PARSE_STAGE_START);
+        }
+
+        p = value_end;
+
+        size_t length = value_end - value;
+
+        switch(step.field) {
+            case FORMAT_FIELD_HOSTNAME:
+                entry.hostname.assign(value, length);
+                break;
+            case FORMAT_FIELD_VHOST:
+                entry.vhost.assign(value, length);
+                break;
+            case FORMAT_FIELD_TIME_CLF:
+                if(!format_log_parse_clf_time(value, value_end, entry.timestamp)) return reject(PARSE_STAGE_DATE);
+                break;
+            case FORMAT_FIELD_TIME_ISO8601:
+                if(!format_log_parse_iso8601_time(value, value_end, entry.timestamp)) return reject(PARSE_STAGE_DATE);
+                break;
+            case FORMAT_FIELD_TIME_SEC:
+            case FORMAT_FIELD_TIME_MSEC:
+            case FORMAT_FIELD_TIME_USEC: {
+                std::string timestr(value, length);
+                char* parse_end = 0;
+                double seconds = strtod(timestr.c_str(), &parse_end);
+
+                if(parse_end == timestr.c_str() || seconds <= 0.0) return reject(PARSE_STAGE_DATE);
+
+                if(step.field == FORMAT_FIELD_TIME_MSEC)      seconds /= 1000.0;
+                else if(step.field == FORMAT_FIELD_TIME_USEC) seconds /= 1000000.0;
+
+                entry.timestamp = (time_t) seconds;
+                break;
+            }
+            case FORMAT_FIELD_REQUEST:
+                format_log_request_path(value, value_end, entry.path);
+                break;
+            case FORMAT_FIELD_PATH:
+                entry.path.assign(value, length);
+                break;
+            case FORMAT_FIELD_QUERY:
+                if(length > 0 && !(length == 1 && *value == '-')) {
+                    if(*value != '?') query = '?';
+                    query.append(value, length);
+                }
+                break;
+            case FORMAT_FIELD_ARGS:
+                if(length > 0 && !(length == 1 && *value == '-')) {
+                    query = '?';
+                    query.append(value, length);
+                }
+                break;
+            case FORMAT_FIELD_STATUS:
+                entry.response_code.assign(value, length);
+                break;
+            case FORMAT_FIELD_SIZE:
+                entry.response_size = atol(std::string(value, length).c_str());
+                break;
+            case FORMAT_FIELD_REFERRER:
+                entry.referrer.assign(value, length);
+                break;
+            case FORMAT_FIELD_USER_AGENT:
+                entry.user_agent.assign(value, length);
+                break;
+            case FORMAT_FIELD_PID:
+                entry.pid.assign(value, length);
+                break;
+            case FORMAT_FIELD_REQUEST_SEC:
+            case FORMAT_FIELD_REQUEST_MSEC:
+            case FORMAT_FIELD_REQUEST_USEC: {
+                double seconds = atof(std::string(value, length).c_str());
+
+                if(step.field == FORMAT_FIELD_REQUEST_MSEC)      seconds /= 1000.0;
+                else if(step.field == FORMAT_FIELD_REQUEST_USEC) seconds /= 1000000.0;
+
+                entry.request_time = (float) seconds;
+                break;
+            }
+            case FORMAT_FIELD_UPSTREAM:
+                entry.upstream.assign(value, length);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if(!query.empty() && !entry.path.empty()) entry.path += query;
+
+    entry.setSuccess();
+    entry.setResponseColour();
+
+    if(!entry.validate()) return reject(PARSE_STAGE_VALIDATE);
+
+    return true;
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMAT_ACCESS_LOG
+#define FORMAT_ACCESS_LOG
+
+#include "logentry.h"
+
+#include <string>
+#include <vector>
+#include <time.h>
+
+enum {
+    FORMAT_FIELD_LITERAL = 0,
+    FORMAT_FIELD_IGNORE,
+    FORMAT_FIELD_HOSTNAME,
+    FORMAT_FIELD_VHOST,
+    FORMAT_FIELD_TIME_CLF,
+    FORMAT_FIELD_TIME_ISO8601,
+    FORMAT_FIELD_TIME_SEC,
+    FORMAT_FIELD_TIME_MSEC,
+    FORMAT_FIELD_TIME_USEC,
+    FORMAT_FIELD_REQUEST,
+    FORMAT_FIELD_PATH,
+    FORMAT_FIELD_QUERY,
+    FORMAT_FIELD_ARGS,
+    FORMAT_FIELD_STATUS,
+    FORMAT_FIELD_SIZE,
+    FORMAT_FIELD_REFERRER,
+    FORMAT_FIELD_USER_AGENT,
+    FORMAT_FIELD_PID,
+    FORMAT_FIELD_REQUEST_SEC,
+    FORMAT_FIELD_REQUEST_MSEC,
+    FORMAT_FIELD_REQUEST_USEC,
+    FORMAT_FIELD_UPSTREAM
+};
+
+// parsing helpers shared with other formats
+bool format_log_parse_clf_time(const char* p, const char* end, time_t& timestamp);
+bool format_log_parse_iso8601_time(const char* p, const char* end, time_t& timestamp);
+void format_log_request_path(const char* p, const char* end, std::string& path);
+
+// one step of a compiled format: either a literal to match or a field to
+// extract up to the first character of the following literal
+
+struct FormatStep {
+    int field;
+    std::string literal;
+    char terminator;
+};
+
+// parses lines described by an Apache LogFormat (%h %t "%r" ...) or nginx
+// log_format ($remote_addr [$time_local] "$request" ...) string. The format
+// is compiled once into a list of steps so no regular expressions are used
+// while parsing.
+
+class FormatLog : public AccessLog {
+    std::vector<FormatStep> steps;
+
+    std::string error;
+    size_t min_length;
+
+    void addLiteral(const std::string& literal);
+    void addField(int field);
+
+    bool compile(const std::string& format);
+
+    bool compileApacheDirective(const std::string& format, size_t& i);
+    bool compileNginxVariable(const std::string& format, size_t& i);
+public:
+    FormatLog(const std::string& format);
+
+    bool isValid() const { return error.empty(); };
+    const std::string& getError() const { return error; };
+
+    bool parseLine(std::string& line, LogEntry& entry);
+};
+
+#endif
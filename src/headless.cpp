@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "headless.h"
+
+#include "core/logger.h"
+
+HeadlessDisplay headless;
+
+HeadlessDisplay::HeadlessDisplay() {
+    multisampled = false;
+#ifdef HAVE_EGL
+    egl_display = EGL_NO_DISPLAY;
+    egl_context = EGL_NO_CONTEXT;
+    egl_surface = EGL_NO_SURFACE;
+#endif
+}
+
+HeadlessDisplay::~HeadlessDisplay() {
+}
+
+bool HeadlessDisplay::supported() {
+#ifdef HAVE_EGL
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef HAVE_EGL
+EGLDisplay HeadlessDisplay::getEGLDisplay() {
+
+    EGLDisplay egl_display = EGL_NO_DISPLAY;
+
+    // prefer Mesa's surfaceless platform so no X11 or Wayland connection is attempted
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if(eglGetPlatformDisplayEXT != 0) {
+        egl_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+    }
+#endif
+
+    if(egl_display == EGL_NO_DISPLAY) {
+        egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    return egl_display;
+}
+#endif
+
+void HeadlessDisplay::init(int width, int height, int samples) {
+#ifdef HAVE_EGL
+
+    egl_display = getEGLDisplay();
+
+    if(egl_display == EGL_NO_DISPLAY) {
+        throw HeadlessDisplayException("no EGL display available");
+    }
+
+    EGLint major, minor;
+
+    if(!eglInitialize(egl_display, &major, &minor)) {
+        throw HeadlessDisplayException("failed to initialize EGL");
+    }
+
+    debugLog("EGL %d.%d (%s)", major, minor, eglQueryString(egl_display, EGL_VENDOR));
+
+    EGLConfig config;
+    EGLint config_count = 0;
+
+    while(true) {
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE,   8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE,  8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_SAMPLE_BUFFERS, samples > 0 ? 1 : 0,
+            EGL_SAMPLES,        samples,
+            EGL_NONE
+        };
+
+        if(eglChooseConfig(egl_display, config_attribs, &config, 1, &config_count) && config_count > 0) break;
+
+        if(samples == 0) {
+            throw HeadlessDisplayException("no suitable EGL framebuffer configuration");
+        }
+
+        //try again without multisampling
+        warnLog("no multisampled EGL framebuffer configuration, multisampling disabled");
+        samples = 0;
+    }
+
+    multisampled = samples > 0;
+
+    const EGLint pbuffer_attribs[] = {
+        EGL_WIDTH,  width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+
+    egl_surface = eglCreatePbufferSurface(egl_display, config, pbuffer_attribs);
+
+    if(egl_surface == EGL_NO_SURFACE) {
+        throw HeadlessDisplayException("failed to create EGL pbuffer surface");
+    }
+
+    // legacy desktop GL is required (immediate mode drawing)
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        throw HeadlessDisplayException("EGL does not support desktop OpenGL");
+    }
+
+    egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, 0);
+
+    if(egl_context == EGL_NO_CONTEXT) {
+        throw HeadlessDisplayException("failed to create EGL context");
+    }
+
+    if(!eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context)) {
+        throw HeadlessDisplayException("failed to make EGL context current");
+    }
+
+    glewExperimental = GL_TRUE;
+    GLenum err = glewInit();
+
+    // GLEW built against GLX reports a missing X display after loading the GL entry points
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if(err == GLEW_ERROR_NO_GLX_DISPLAY) err = GLEW_OK;
+#endif
+
+    if(err != GLEW_OK) {
+        throw HeadlessDisplayException(std::string("GLEW error: ") + (const char*) glewGetErrorString(err));
+    }
+
+    debugLog("headless renderer: %s", (const char*) glGetString(GL_RENDERER));
+
+    display.width  = width;
+    display.height = height;
+
+    glViewport(0, 0, width, height);
+#else
+    throw HeadlessDisplayException("headless rendering requires EGL support");
+#endif
+}
+
+void HeadlessDisplay::quit() {
+#ifdef HAVE_EGL
+    if(egl_display == EGL_NO_DISPLAY) return;
+
+    texturemanager.purge();
+    shadermanager.purge();
+    fontmanager.purge();
+
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if(egl_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_context);
+    if(egl_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, egl_surface);
+
+    eglTerminate(egl_display);
+
+    egl_display = EGL_NO_DISPLAY;
+    egl_context = EGL_NO_CONTEXT;
+    egl_surface = EGL_NO_SURFACE;
+#endif
+}
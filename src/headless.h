@@ -0,0 +1,68 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADLESS_DISPLAY_H
+#define HEADLESS_DISPLAY_H
+
+#include "core/display.h"
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <string>
+#include <exception>
+
+class HeadlessDisplayException : public std::exception {
+protected:
+    std::string message;
+public:
+    HeadlessDisplayException(const std::string& message) : message(message) {}
+    virtual ~HeadlessDisplayException() throw () {};
+
+    virtual const char* what() const throw() { return message.c_str(); }
+};
+
+// Offscreen OpenGL context with no window system (EGL pbuffer surface).
+// Replaces display.init() when rendering video on machines without a display.
+
+class HeadlessDisplay {
+    bool multisampled;
+#ifdef HAVE_EGL
+    EGLDisplay egl_display;
+    EGLContext egl_context;
+    EGLSurface egl_surface;
+
+    EGLDisplay getEGLDisplay();
+#endif
+public:
+    HeadlessDisplay();
+    ~HeadlessDisplay();
+
+    static bool supported();
+
+    // samples > 0 requests a multisampled framebuffer if one is available
+    void init(int width, int height, int samples = 0);
+
+    bool isMultisampled() const { return multisampled; };
+    void quit();
+};
+
+extern HeadlessDisplay headless;
+
+#endif
@@ -0,0 +1,603 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "jsonlog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// names of entry fields used by --json-fields
+struct JSONFieldName {
+    const char* name;
+    int field;
+};
+
+const JSONFieldName json_log_field_names[] = {
+    { "host",            FORMAT_FIELD_HOSTNAME     },
+    { "vhost",           FORMAT_FIELD_VHOST        },
+    { "time",            FORMAT_FIELD_TIME_SEC     },
+    { "request",         FORMAT_FIELD_REQUEST      },
+    { "path",            FORMAT_FIELD_PATH         },
+    { "args",            FORMAT_FIELD_ARGS         },
+    { "status",          FORMAT_FIELD_STATUS       },
+    { "size",            FORMAT_FIELD_SIZE         },
+    { "referrer",        FORMAT_FIELD_REFERRER     },
+    { "user_agent",      FORMAT_FIELD_USER_AGENT   },
+    { "pid",             FORMAT_FIELD_PID          },
+    { "request_time",    FORMAT_FIELD_REQUEST_SEC  },
+    { "request_time_ms", FORMAT_FIELD_REQUEST_MSEC },
+    { "request_time_us", FORMAT_FIELD_REQUEST_USEC },
+    { "upstream",        FORMAT_FIELD_UPSTREAM     },
+    { 0, 0 }
+};
+
+// keys written by common nginx, Caddy and Envoy JSON log configurations
+const JSONFieldName json_log_default_keys[] = {
+    { "remote_addr",               FORMAT_FIELD_HOSTNAME    },
+    { "remote_ip",                 FORMAT_FIELD_HOSTNAME    },
+    { "client_ip",                 FORMAT_FIELD_HOSTNAME    },
+    { "request.remote_ip",         FORMAT_FIELD_HOSTNAME    },
+    { "request.client_ip",         FORMAT_FIELD_HOSTNAME    },
+    { "downstream_remote_address", FORMAT_FIELD_HOSTNAME    },
+    { "host",                      FORMAT_FIELD_VHOST       },
+    { "http_host",                 FORMAT_FIELD_VHOST       },
+    { "server_name",               FORMAT_FIELD_VHOST       },
+    { "authority",                 FORMAT_FIELD_VHOST       },
+    { "request.host",              FORMAT_FIELD_VHOST       },
+    { "time_iso8601",              FORMAT_FIELD_TIME_SEC    },
+    { "time_local",                FORMAT_FIELD_TIME_SEC    },
+    { "timestamp",                 FORMAT_FIELD_TIME_SEC    },
+    { "@timestamp",                FORMAT_FIELD_TIME_SEC    },
+    { "time",                      FORMAT_FIELD_TIME_SEC    },
+    { "start_time",                FORMAT_FIELD_TIME_SEC    },
+    { "ts",                        FORMAT_FIELD_TIME_SEC    },
+    { "request",                   FORMAT_FIELD_REQUEST     },
+    { "request_uri",               FORMAT_FIELD_PATH        },
+    { "uri",                       FORMAT_FIELD_PATH        },
+    { "path",                      FORMAT_FIELD_PATH        },
+    { "url",                       FORMAT_FIELD_PATH        },
+    { "request.uri",               FORMAT_FIELD_PATH        },
+    { "args",                      FORMAT_FIELD_ARGS        },
+    { "query_string",              FORMAT_FIELD_ARGS        },
+    { "status",                    FORMAT_FIELD_STATUS      },
+    { "response_code",             FORMAT_FIELD_STATUS      },
+    { "status_code",               FORMAT_FIELD_STATUS      },
+    { "body_bytes_sent",           FORMAT_FIELD_SIZE        },
+    { "bytes_sent",                FORMAT_FIELD_SIZE        },
+    { "size",                      FORMAT_FIELD_SIZE        },
+    { "response_size",             FORMAT_FIELD_SIZE        },
+    { "http_referer",              FORMAT_FIELD_REFERRER    },
+    { "referer",                   FORMAT_FIELD_REFERRER    },
+    { "referrer",                  FORMAT_FIELD_REFERRER    },
+    { "http_user_agent",           FORMAT_FIELD_USER_AGENT  },
+    { "user_agent",                FORMAT_FIELD_USER_AGENT  },
+    { "pid",                       FORMAT_FIELD_PID         },
+    { "request_time",              FORMAT_FIELD_REQUEST_SEC },
+    { "duration",                  FORMAT_FIELD_REQUEST_SEC },
+    { "upstream_addr",             FORMAT_FIELD_UPSTREAM    },
+    { "upstream_host",             FORMAT_FIELD_UPSTREAM    },
+    { 0, 0 }
+};
+
+inline void json_log_skip_space(const char*& p, const char* end) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+}
+
+// p is after the opening quote. finds the closing quote, leaving p after it
+inline bool json_log_scan_string(const char*& p, const char* end, const char*& string_end) {
+
+    const char* start = p;
+
+    while(p < end) {
+        const char* quote = (const char*) memchr(p, '"', end - p);
+
+        if(quote == 0) return false;
+
+        //the quote is escaped if preceded by an odd number of backslashes
+        const char* backslash = quote;
+        while(backslash > start && *(backslash-1) == '\\') backslash--;
+
+        p = quote + 1;
+
+        if(((quote - backslash) & 1) == 0) {
+            string_end = quote;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// appends a code point as UTF-8
+void json_log_append_utf8(std::string& output, unsigned int code) {
+    if(code < 0x80) {
+        output += (char) code;
+    } else if(code < 0x800) {
+        output += (char) (0xC0 | (code >> 6));
+        output += (char) (0x80 | (code & 0x3F));
+    } else if(code < 0x10000) {
+        output += (char) (0xE0 | (code >> 12));
+        output += (char) (0x80 | ((code >> 6) & 0x3F));
+        output += (char) (0x80 | (code & 0x3F));
+    } else {
+        output += (char) (0xF0 | (code >> 18));
+        output += (char) (0x80 | ((code >> 12) & 0x3F));
+        output += (char) (0x80 | ((code >> 6) & 0x3F));
+        output += (char) (0x80 | (code & 0x3F));
+    }
+}
+
+bool json_log_read_hex4(const char* p, const char* end, unsigned int& code) {
+    if(end - p < 4) return false;
+
+    code = 0;
+
+    for(int i=0; i<4; i++) {
+        char c = p[i];
+        code <<= 4;
+
+        if(c >= '0' && c <= '9')      code |= c - '0';
+        else if(c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return false;
+    }
+
+    return true;
+}
+
+void json_log_unescape(const char* p, const char* end, std::string& output) {
+
+    output.clear();
+    output.reserve(end - p);
+
+    while(p < end) {
+
+        if(*p != '\\' || p+1 >= end) {
+            output += *p++;
+            continue;
+        }
+
+        char c = p[1];
+        p += 2;
+
+        switch(c) {
+            case 'b': output += '\b'; break;
+            case 'f': output += '\f'; break;
+            case 'n': output += '\n'; break;
+            case 'r': output += '\r'; break;
+            case 't': output += '\t'; break;
+            case 'u': {
+                unsigned int code;
+
+                if(!json_log_read_hex4(p, end, code)) break;
+                p += 4;
+
+                //surrogate pair
+                unsigned int low;
+                if(code >= 0xD800 && code <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u'
+                   && json_log_read_hex4(p+2, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+
+                json_log_append_utf8(output, code);
+                break;
+            }
+            default:
+                output += c;
+                break;
+        }
+    }
+}
+
+JSONLog::JSONLog(const std::string& field_mapping) {
+
+    field_mappings = 0;
+
+    //mappings given by the user take precedence over the defaults
+    size_t start = 0;
+
+    while(start < field_mapping.size()) {
+
+        size_t comma = field_mapping.find(',', start);
+        if(comma == std::string::npos) comma = field_mapping.size();
+
+        std::string pair = field_mapping.substr(start, comma - start);
+        start = comma + 1;
+
+        if(pair.empty()) continue;
+
+        size_t equals = pair.find('=');
+
+        if(equals == std::string::npos || equals == 0 || equals == pair.size()-1) {
+            error = "expected FIELD=KEY in '" + pair + "'";
+            return;
+        }
+
+        std::string name = pair.substr(0, equals);
+        std::string key  = pair.substr(equals+1);
+
+        int field = -1;
+
+        for(int i=0; json_log_field_names[i].name != 0; i++) {
+            if(name == json_log_field_names[i].name) {
+                field = json_log_field_names[i].field;
+                break;
+            }
+        }
+
+        if(field == -1) {
+            error = "unknown field '" + name + "'";
+            return;
+        }
+
+        addMapping(key, field);
+    }
+
+    for(int i=0; json_log_default_keys[i].name != 0; i++) {
+        addMapping(json_log_default_keys[i].name, json_log_default_keys[i].field);
+    }
+}
+
+inline unsigned int json_log_hash(const char* key, size_t length) {
+
+    //FNV-1a
+    unsigned int hash = 2166136261U;
+
+    for(size_t i=0; i<length; i++) {
+        hash ^= (unsigned char) key[i];
+        hash *= 16777619U;
+    }
+
+    return hash % JSON_LOG_KEY_TABLE;
+}
+
+void JSONLog::addMapping(const std::string& key, int field) {
+
+    //a key is only used for the first field it is mapped to
+    for(const JSONFieldMapping& mapping : mappings) {
+        if(!mapping.object && mapping.key == key) return;
+    }
+
+    addKey(key, field, false);
+
+    size_t dot = key.find('.');
+
+    while(dot != std::string::npos) {
+        std::string prefix = key.substr(0, dot);
+
+        bool exists = false;
+
+        for(const JSONFieldMapping& mapping : mappings) {
+            if(mapping.object && mapping.key == prefix) {
+                exists = true;
+                break;
+            }
+        }
+
+        if(!exists) addKey(prefix, -1, true);
+
+        dot = key.find('.', dot+1);
+    }
+}
+
+void JSONLog::addKey(const std::string& key, int field, bool object) {
+
+    JSONFieldMapping mapping;
+    mapping.key      = key;
+    mapping.field    = field;
+    mapping.priority = object ? INT_MAX : field_mappings++;
+    mapping.object   = object;
+
+    key_table[json_log_hash(key.data(), key.size())].push_back(mappings.size());
+
+    mappings.push_back(mapping);
+}
+
+// skips any value, p is at its first character
+bool JSONLog::skipValue(const char*& p, const char* end, int depth) {
+
+    if(p >= end) return false;
+
+    const char* string_end;
+
+    if(*p == '"') {
+        p++;
+        return json_log_scan_string(p, end, string_end);
+    }
+
+    if(*p == '{' || *p == '[') {
+
+        int nesting = 0;
+
+        while(p < end) {
+            char c = *p;
+
+            if(c == '"') {
+                p++;
+                if(!json_log_scan_string(p, end, string_end)) return false;
+                continue;
+            }
+
+            p++;
+
+            if(c == '{' || c == '[') {
+                nesting++;
+            } else if(c == '}' || c == ']') {
+                if(--nesting == 0) return true;
+            }
+        }
+
+        return false;
+    }
+
+    //number, true, false or null
+    const char* start = p;
+
+    while(p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+
+    return p > start;
+}
+
+// p is at the opening brace of an object
+bool JSONLog::scanObject(const char*& p, const char* end, int depth, bool search) {
+
+    p++;
+
+    json_log_skip_space(p, end);
+
+    if(p < end && *p == '}') {
+        p++;
+        return true;
+    }
+
+    const char* key_end;
+
+    while(p < end) {
+
+        json_log_skip_space(p, end);
+
+        if(p >= end || *p != '"') return false;
+
+        const char* key = ++p;
+
+        if(!json_log_scan_string(p, end, key_end)) return false;
+
+        json_log_skip_space(p, end);
+
+        if(p >= end || *p != ':') return false;
+        p++;
+
+        json_log_skip_space(p, end);
+
+        if(p >= end) return false;
+
+        size_t parent_length = key_path.size();
+
+        int field    = -1;
+        int priority = INT_MAX;
+
+        bool descend = false;
+
+        if(search) {
+            if(parent_length > 0) key_path += '.';
+            key_path.append(key, key_end - key);
+
+            for(int index : key_table[json_log_hash(key_path.data(), key_path.size())]) {
+
+                const JSONFieldMapping& mapping = mappings[index];
+
+                if(mapping.key.size() != key_path.size() || memcmp(mapping.key.data(), key_path.data(), key_path.size()) != 0) continue;
+
+                if(mapping.object) {
+                    descend = (*p == '{' && depth+1 < JSON_LOG_MAX_DEPTH);
+                } else {
+                    field    = mapping.field;
+                    priority = mapping.priority;
+                }
+            }
+        }
+
+        if(descend) {
+            if(!scanObject(p, end, depth+1, true)) return false;
+
+        } else if(field != -1 && *p == '"') {
+
+            const char* value = ++p;
+            const char* value_end;
+
+            if(!json_log_scan_string(p, end, value_end)) return false;
+
+            if(priority < values[field].priority) {
+                values[field].start    = value;
+                values[field].end      = value_end;
+                values[field].quoted   = true;
+                values[field].escaped  = memchr(value, '\\', value_end - value) != 0;
+                values[field].priority = priority;
+            }
+
+        } else {
+            const char* value = p;
+
+            if(!skipValue(p, end, depth)) return false;
+
+            //nulls are treated as missing
+            if(field != -1 && priority < values[field].priority && *value != 'n' && *value != '{' && *value != '[') {
+                values[field].start    = value;
+                values[field].end      = p;
+                values[field].quoted   = false;
+                values[field].escaped  = false;
+                values[field].priority = priority;
+            }
+        }
+
+        key_path.resize(parent_length);
+
+        json_log_skip_space(p, end);
+
+        if(p >= end) return false;
+
+        if(*p == ',') {
+            p++;
+            continue;
+        }
+
+        if(*p == '}') {
+            p++;
+            return true;
+        }
+
+        return false;
+    }
+
+    return false;
+}
+
+void JSONLog::valueString(const JSONValue& value, std::string& output) {
+    if(value.escaped) {
+        json_log_unescape(value.start, value.end, output);
+    } else {
+        output.assign(value.start, value.end - value.start);
+    }
+}
+
+bool JSONLog::parseLine(std::string& line, LogEntry& entry) {
+
+    const char* p   = line.c_str();
+    const char* end = p + line.size();
+
+    json_log_skip_space(p, end);
+
+    if(p >= end || *p != '{' || !isValid()) {
+        return reject(PARSE_STAGE_PREFILTER);
+    }
+
+    for(int i=0; i<=FORMAT_FIELD_UPSTREAM; i++) {
+        values[i].priority = INT_MAX;
+    }
+
+    key_path.clear();
+
+    if(!scanObject(p, end, 0, true)) return reject(PARSE_STAGE_START);
+
+    std::string value;
+
+    //remote address, removing any port
+    if(values[FORMAT_FIELD_HOSTNAME].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_HOSTNAME], entry.hostname);
+
+        if(!entry.hostname.empty() && entry.hostname[0] == '[') {
+            size_t close = entry.hostname.find(']');
+            if(close != std::string::npos) entry.hostname = entry.hostname.substr(1, close-1);
+        } else {
+            size_t colon = entry.hostname.find(':');
+            if(colon != std::string::npos && entry.hostname.find(':', colon+1) == std::string::npos) {
+                entry.hostname.resize(colon);
+            }
+        }
+    }
+
+    //timestamp as a date string or seconds, milliseconds or microseconds since the epoch
+    const JSONValue& time_value = values[FORMAT_FIELD_TIME_SEC];
+
+    if(time_value.priority == INT_MAX) return reject(PARSE_STAGE_DATE);
+
+    if(   !time_value.quoted
+       || (   !format_log_parse_iso8601_time(time_value.start, time_value.end, entry.timestamp)
+           && !format_log_parse_clf_time(time_value.start, time_value.end, entry.timestamp))) {
+
+        char* number_end = 0;
+        double seconds = strtod(time_value.start, &number_end);
+
+        if(number_end != time_value.end || seconds <= 0.0) return reject(PARSE_STAGE_DATE);
+
+        if(seconds > 1e14)      seconds /= 1000000.0;
+        else if(seconds > 1e11) seconds /= 1000.0;
+
+        entry.timestamp = (time_t) seconds;
+    }
+
+    //path, or the path of the request line
+    if(values[FORMAT_FIELD_PATH].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_PATH], entry.path);
+    } else if(values[FORMAT_FIELD_REQUEST].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_REQUEST], value);
+        format_log_request_path(value.c_str(), value.c_str() + value.size(), entry.path);
+    } else {
+        return reject(PARSE_STAGE_REQUEST);
+    }
+
+    if(values[FORMAT_FIELD_ARGS].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_ARGS], value);
+        if(!value.empty() && value != "-") entry.path += "?" + value;
+    }
+
+    if(values[FORMAT_FIELD_STATUS].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_STATUS], entry.response_code);
+    }
+
+    if(values[FORMAT_FIELD_SIZE].priority != INT_MAX) {
+        const JSONValue& size_value = values[FORMAT_FIELD_SIZE];
+        entry.response_size = atol(size_value.start);
+    }
+
+    if(values[FORMAT_FIELD_VHOST].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_VHOST], entry.vhost);
+    }
+
+    if(values[FORMAT_FIELD_REFERRER].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_REFERRER], entry.referrer);
+    }
+
+    if(values[FORMAT_FIELD_USER_AGENT].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_USER_AGENT], entry.user_agent);
+    }
+
+    if(values[FORMAT_FIELD_PID].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_PID], entry.pid);
+    }
+
+    if(values[FORMAT_FIELD_UPSTREAM].priority != INT_MAX) {
+        valueString(values[FORMAT_FIELD_UPSTREAM], entry.upstream);
+    }
+
+    //request time in whichever unit has the preferred mapping
+    int time_field = -1;
+
+    for(int field = FORMAT_FIELD_REQUEST_SEC; field <= FORMAT_FIELD_REQUEST_USEC; field++) {
+        if(values[field].priority != INT_MAX && (time_field == -1 || values[field].priority < values[time_field].priority)) {
+            time_field = field;
+        }
+    }
+
+    if(time_field != -1) {
+        double seconds = atof(values[time_field].start);
+
+        if(time_field == FORMAT_FIELD_REQUEST_MSEC)      seconds /= 1000.0;
+        else if(time_field == FORMAT_FIELD_REQUEST_USEC) seconds /= 1000000.0;
+
+        entry.request_time = (float) seconds;
+    }
+
+    entry.setSuccess();
+    entry.setResponseColour();
+
+    if(!entry.validate()) return reject(PARSE_STAGE_VALIDATE);
+
+    return true;
+}
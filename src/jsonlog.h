@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JSON_ACCESS_LOG
+#define JSON_ACCESS_LOG
+
+#include "logentry.h"
+#include "formatlog.h"
+
+#include <string>
+#include <vector>
+
+// nesting deeper than this is skipped without looking for fields
+#define JSON_LOG_MAX_DEPTH 8
+
+// buckets of the key lookup table
+#define JSON_LOG_KEY_TABLE 64
+
+// a JSON key (dotted for nested objects, eg request.uri) assigned to an
+// entry field. Earlier mappings take precedence over later ones. Objects
+// containing mapped keys (eg request) are also entered so the scan knows
+// to descend into them.
+
+struct JSONFieldMapping {
+    std::string key;
+    int field;
+    int priority;
+    bool object;
+};
+
+// a value found in the current line
+struct JSONValue {
+    const char* start;
+    const char* end;
+    bool quoted;
+    bool escaped;
+    int  priority;
+};
+
+// parses one JSON object per line. Values are located with a single
+// forward scan that skips anything not mapped to a field, and only the
+// mapped values are converted.
+
+class JSONLog : public AccessLog {
+    std::vector<JSONFieldMapping> mappings;
+    std::vector<int> key_table[JSON_LOG_KEY_TABLE];
+    int field_mappings;
+
+    JSONValue values[FORMAT_FIELD_UPSTREAM+1];
+
+    std::string key_path;
+    std::string error;
+
+    void addMapping(const std::string& key, int field);
+    void addKey(const std::string& key, int field, bool object);
+
+    bool scanObject(const char*& p, const char* end, int depth, bool search);
+    bool skipValue(const char*& p, const char* end, int depth);
+
+    void valueString(const JSONValue& value, std::string& output);
+public:
+    JSONLog(const std::string& field_mapping = "");
+
+    bool isValid() const { return error.empty(); };
+    const std::string& getError() const { return error; };
+
+    bool parseLine(std::string& line, LogEntry& entry);
+};
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "keyframes.h"
+
+#include <algorithm>
+
+static bool keyframe_before(const Keyframe& keyframe, time_t time) {
+    return keyframe.time < time;
+}
+
+static bool keyframe_after(time_t time, const Keyframe& keyframe) {
+    return time < keyframe.time;
+}
+
+KeyframeIndex::KeyframeIndex() {
+    interval = KEYFRAME_INTERVAL;
+}
+
+void KeyframeIndex::add(time_t time, float position, long highscore) {
+
+    auto it = std::lower_bound(keyframes.begin(), keyframes.end(), time, keyframe_before);
+
+    //already have a keyframe close to this time
+    if(it != keyframes.end() && it->time < time + interval) return;
+    if(it != keyframes.begin() && (it-1)->time > time - interval) return;
+
+    Keyframe keyframe;
+    keyframe.time      = time;
+    keyframe.position  = position;
+    keyframe.highscore = highscore;
+
+    keyframes.insert(it, keyframe);
+
+    if(keyframes.size() > KEYFRAME_LIMIT) thin();
+}
+
+//keep every other keyframe so the whole log is still covered
+void KeyframeIndex::thin() {
+
+    size_t kept = 0;
+
+    for(size_t i=0; i<keyframes.size(); i+=2) {
+        keyframes[kept++] = keyframes[i];
+    }
+
+    keyframes.resize(kept);
+
+    interval *= 2;
+}
+
+const Keyframe* KeyframeIndex::before(time_t time) const {
+
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), time, keyframe_after);
+
+    if(it == keyframes.begin()) return 0;
+
+    return &(*(it-1));
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_KEYFRAMES_H
+#define LOGSTALGIA_KEYFRAMES_H
+
+#include <vector>
+#include <time.h>
+
+// initial seconds of log between keyframes
+#define KEYFRAME_INTERVAL 10
+
+// keyframes kept before every other one is dropped and the interval doubled
+// (about a day of log at the initial interval)
+#define KEYFRAME_LIMIT 8192
+
+// least seconds simulated before the time restored, raised to the lifetime
+// of a ball so requests still on screen at that time are spawned again
+#define KEYFRAME_LEAD 5
+
+// most seconds of log simulated to restore a keyframe, beyond which the
+// position is sought to instead
+#define KEYFRAME_MAX_REPLAY 30
+
+// seconds of log simulated per tick when restoring a keyframe
+#define KEYFRAME_REPLAY_STEP 0.1f
+
+// seconds gone back by pressing 'b'
+#define KEYFRAME_REWIND 30
+
+struct Keyframe {
+    time_t time;
+
+    // position in the log of the first entry at the time
+    float position;
+
+    long highscore;
+};
+
+// Keyframes recorded as the log is played, so an earlier time can be
+// returned to by seeking to the keyframe before it and simulating forward
+// from there. Keyframes are kept in time order, at most one per interval.
+
+class KeyframeIndex {
+    std::vector<Keyframe> keyframes;
+    int interval;
+
+    void thin();
+public:
+    KeyframeIndex();
+
+    void add(time_t time, float position, long highscore);
+
+    // latest keyframe at or before the time, or 0
+    const Keyframe* before(time_t time) const;
+
+    int getInterval() const { return interval; };
+    size_t size() const { return keyframes.size(); };
+};
+
+#endif
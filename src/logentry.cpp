@@ -24,6 +24,53 @@
 //AccessLog
 
 AccessLog::AccessLog() {
+    error_stage = PARSE_STAGE_PREFILTER;
+}
+
+//ParseErrors
+
+ParseErrors::ParseErrors() {
+    for(int i=0; i<PARSE_STAGES; i++) counts[i] = 0;
+
+    total = 0;
+    random_state = 1;
+}
+
+const char* ParseErrors::stageName(int stage) {
+    switch(stage) {
+        case PARSE_STAGE_PREFILTER: return "prefilter";
+        case PARSE_STAGE_START:     return "start";
+        case PARSE_STAGE_DATE:      return "date";
+        case PARSE_STAGE_REQUEST:   return "request";
+        case PARSE_STAGE_VALIDATE:  return "validate";
+    }
+    return "unknown";
+}
+
+void ParseErrors::add(int stage, const std::string& line) {
+
+    if(stage < 0 || stage >= PARSE_STAGES) return;
+
+    counts[stage]++;
+    total++;
+
+    //reservoir sampling: every rejected line has an equal chance of being kept
+    size_t slot = samples.size();
+
+    if(samples.size() >= PARSE_ERROR_SAMPLES) {
+        random_state = random_state * 1103515245 + 12345;
+        slot = ((random_state >> 1) % total);
+
+        if(slot >= PARSE_ERROR_SAMPLES) return;
+    }
+
+    std::string sample = std::string(stageName(stage)) + ": " + line.substr(0, 256);
+
+    if(slot < samples.size()) {
+        samples[slot] = sample;
+    } else {
+        samples.push_back(sample);
+    }
 }
 
 //LogEntry
@@ -31,6 +78,8 @@ AccessLog::AccessLog() {
 LogEntry::LogEntry() {
     timestamp = 0;
     response_size = 0;
+    request_time = 0.0f;
+    received = 0;
     successful = false;
     response_colour = vec3(1.0, 0.0, 0.0);
 }
@@ -137,6 +186,7 @@ void LogEntry::setResponseColour() {
 bool LogEntry::validate() {
     if(pid == "-") pid = "";
     if(referrer == "-") referrer = "";
+    if(upstream == "-") upstream = "";
 
     if(hostname.empty()) return false;
 
@@ -21,11 +21,23 @@
 #include "core/vectors.h"
 
 #include <string>
+#include <vector>
+#include <stdint.h>
+
+// stage of AccessLog::parseLine at which a line was rejected
+enum {
+    PARSE_STAGE_PREFILTER = 0,
+    PARSE_STAGE_START,
+    PARSE_STAGE_DATE,
+    PARSE_STAGE_REQUEST,
+    PARSE_STAGE_VALIDATE,
+    PARSE_STAGES
+};
 
-class LogEntry {
+// number of rejected lines kept as examples
+#define PARSE_ERROR_SAMPLES 16
 
-private:
-    std::string maskHostname(const std::string& hostname);
+class LogEntry {
 public:
     LogEntry();
     bool validate();
@@ -33,6 +45,8 @@ public:
     void setSuccess();
     void setResponseColour();
 
+    std::string maskHostname(const std::string& hostname);
+
     time_t timestamp;
 
     std::string hostname;
@@ -48,18 +62,57 @@ public:
     std::string referrer;
     std::string user_agent;
 
+    //seconds taken to serve the request, if logged
+    float request_time;
+
+    //address of the upstream server that handled the request, if proxied
+    std::string upstream;
+
+    //profiler ticks when the line was received, if measured
+    uint64_t received;
+
     vec3 response_colour;
 
     bool successful;
 };
 
 class AccessLog {
+protected:
+    int error_stage;
 
+    bool reject(int stage) {
+        error_stage = stage;
+        return false;
+    }
 public:
     AccessLog();
     virtual ~AccessLog() {};
     virtual bool parseLine(std::string& line, LogEntry& entry) = 0;
 
+    // stage the last rejected line failed at
+    int getErrorStage() const { return error_stage; }
+};
+
+// counts rejected lines by parse stage, keeping a uniformly sampled
+// reservoir of example lines
+
+class ParseErrors {
+    long counts[PARSE_STAGES];
+    long total;
+
+    std::vector<std::string> samples;
+    unsigned int random_state;
+public:
+    ParseErrors();
+
+    void add(int stage, const std::string& line);
+
+    long getTotal() const { return total; };
+    long getCount(int stage) const { return counts[stage]; };
+
+    const std::vector<std::string>& getSamples() const { return samples; };
+
+    static const char* stageName(int stage);
 };
 
 #endif
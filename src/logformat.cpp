@@ -0,0 +1,306 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logformat.h"
+
+#include "ncsa.h"
+#include "custom.h"
+#include "jsonlog.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+AccessLog* create_ncsa_log() {
+    return new NCSALog();
+}
+
+AccessLog* create_custom_log() {
+    return new CustomAccessLog();
+}
+
+AccessLog* create_json_log() {
+    return new JSONLog();
+}
+
+const std::vector<AccessLogFormat>& accessLogFormats() {
+
+    static std::vector<AccessLogFormat> formats = {
+        { "ncsa",   create_ncsa_log   },
+        { "custom", create_custom_log },
+        { "json",   create_json_log   }
+    };
+
+    return formats;
+}
+
+AccessLog* createAccessLog(const std::string& name) {
+
+    for(const AccessLogFormat& format : accessLogFormats()) {
+        if(name == format.name) return format.create();
+    }
+
+    return 0;
+}
+
+// FormatDetector
+
+FormatDetector::FormatDetector() {
+    for(const AccessLogFormat& format : accessLogFormats()) {
+        candidates.push_back(format.create());
+        scores.push_back(0);
+    }
+}
+
+FormatDetector::~FormatDetector() {
+    for(AccessLog* candidate : candidates) {
+        if(candidate != 0) delete candidate;
+    }
+}
+
+void FormatDetector::addLine(const std::string& line) {
+
+    int furthest_stage = PARSE_STAGE_PREFILTER;
+
+    for(size_t i=0; i<candidates.size(); i++) {
+
+        //parseLine is allowed to modify the line
+        std::string linestr = line;
+        LogEntry le;
+
+        if(candidates[i]->parseLine(linestr, le)) {
+            scores[i]++;
+        } else {
+            furthest_stage = std::max(furthest_stage, candidates[i]->getErrorStage());
+        }
+    }
+
+    lines.push_back(line);
+    error_stages.push_back(furthest_stage);
+}
+
+bool FormatDetector::matched() const {
+    return best() != -1;
+}
+
+int FormatDetector::best() const {
+
+    int best_index = -1;
+    int best_score = 0;
+
+    for(size_t i=0; i<scores.size(); i++) {
+        if(scores[i] > best_score) {
+            best_index = i;
+            best_score = scores[i];
+        }
+    }
+
+    return best_index;
+}
+
+AccessLog* FormatDetector::commit() {
+
+    int index = best();
+
+    if(index == -1) return 0;
+
+    debugLog("detected %s log format (%d of %d sampled lines)",
+             accessLogFormats()[index].name, scores[index], (int) lines.size());
+
+    AccessLog* accesslog = candidates[index];
+    candidates[index] = 0;
+
+    return accesslog;
+}
+
+void FormatDetector::clear() {
+    lines.clear();
+    error_stages.clear();
+
+    for(size_t i=0; i<scores.size(); i++) {
+        scores[i] = 0;
+    }
+}
+
+// FormatCache
+
+FormatCache::FormatCache() {
+#ifndef _WIN32
+
+    const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+    const char* home           = getenv("HOME");
+
+    if(xdg_cache_home != 0 && xdg_cache_home[0] != '\0') {
+        cache_dir = xdg_cache_home;
+    } else if(home != 0 && home[0] != '\0') {
+        cache_dir = std::string(home) + "/.cache";
+    } else {
+        return;
+    }
+
+    cache_dir += "/logstalgia";
+
+    cache_file = cache_dir + "/formats";
+#endif
+}
+
+std::string FormatCache::fileKey(const std::string& logfile) {
+
+    struct stat finfo;
+
+    if(stat(logfile.c_str(), &finfo) != 0 || !S_ISREG(finfo.st_mode)) return "";
+
+    FILE* file = fopen(logfile.c_str(), "rb");
+
+    if(file == 0) return "";
+
+    //hash the first line, or the first 1024 bytes of it
+    char buff[1024];
+    size_t read = fread(buff, 1, sizeof(buff), file);
+
+    fclose(file);
+
+    if(read == 0) return "";
+
+    size_t length = 0;
+
+    while(length < read && buff[length] != '\n') length++;
+
+    //wait for the first line to be complete
+    if(length == read && read < sizeof(buff)) return "";
+
+    //FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for(size_t i=0; i<length; i++) {
+        hash ^= (unsigned char) buff[i];
+        hash *= 1099511628211ULL;
+    }
+
+    char key[128];
+    snprintf(key, sizeof(key), "%llx:%llx:%016llx",
+             (unsigned long long) finfo.st_dev, (unsigned long long) finfo.st_ino, hash);
+
+    return key;
+}
+
+std::vector<std::pair<std::string,std::string> > FormatCache::read() {
+
+    std::vector<std::pair<std::string,std::string> > entries;
+
+    if(cache_file.empty()) return entries;
+
+    FILE* file = fopen(cache_file.c_str(), "r");
+
+    if(file == 0) return entries;
+
+    char buff[256];
+    char key[128];
+    char format[64];
+
+    while(fgets(buff, sizeof(buff), file) != 0) {
+        if(sscanf(buff, "%127s %63s", key, format) == 2) {
+            entries.push_back(std::make_pair(std::string(key), std::string(format)));
+        }
+    }
+
+    fclose(file);
+
+    return entries;
+}
+
+void FormatCache::write(const std::vector<std::pair<std::string,std::string> >& entries) {
+
+#ifndef _WIN32
+    if(cache_file.empty()) return;
+
+    //directories are only created once there is something to cache
+    size_t parent = cache_dir.rfind('/');
+
+    if(parent != std::string::npos && parent > 0) {
+        mkdir(cache_dir.substr(0, parent).c_str(), 0755);
+    }
+
+    mkdir(cache_dir.c_str(), 0755);
+
+    //replace the cache atomically in case another instance is reading it
+    char temp_file[1024];
+    snprintf(temp_file, sizeof(temp_file), "%s.%ld", cache_file.c_str(), (long) getpid());
+
+    FILE* file = fopen(temp_file, "w");
+
+    if(file == 0) return;
+
+    //drop the oldest entries
+    size_t first = entries.size() > FORMAT_CACHE_ENTRIES ? entries.size() - FORMAT_CACHE_ENTRIES : 0;
+
+    for(size_t i=first; i<entries.size(); i++) {
+        fprintf(file, "%s %s\n", entries[i].first.c_str(), entries[i].second.c_str());
+    }
+
+    fclose(file);
+
+    if(rename(temp_file, cache_file.c_str()) != 0) {
+        remove(temp_file);
+    }
+#endif
+}
+
+std::string FormatCache::lookup(const std::string& key) {
+
+    if(key.empty()) return "";
+
+    std::vector<std::pair<std::string,std::string> > entries = read();
+
+    for(auto& entry : entries) {
+        if(entry.first == key) return entry.second;
+    }
+
+    return "";
+}
+
+void FormatCache::store(const std::string& key, const std::string& format) {
+
+    if(key.empty()) return;
+
+    std::vector<std::pair<std::string,std::string> > entries = read();
+
+    //most recently stored entries go last
+    for(auto it = entries.begin(); it != entries.end(); it++) {
+        if(it->first == key) {
+            entries.erase(it);
+            break;
+        }
+    }
+
+    if(!format.empty()) entries.push_back(std::make_pair(key, format));
+
+    write(entries);
+}
+
+void FormatCache::forget(const std::string& key) {
+    store(key, "");
+}
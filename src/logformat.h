@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_LOGFORMAT_H
+#define LOGSTALGIA_LOGFORMAT_H
+
+#include "logentry.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// number of lines sampled before committing to a log format
+#define FORMAT_DETECT_LINES 20
+
+// entries kept in the format cache
+#define FORMAT_CACHE_ENTRIES 256
+
+// a known AccessLog implementation
+struct AccessLogFormat {
+    const char* name;
+    AccessLog* (*create)();
+};
+
+// registered formats in order of preference (ties go to the earliest)
+const std::vector<AccessLogFormat>& accessLogFormats();
+
+AccessLog* createAccessLog(const std::string& name);
+
+// scores every registered format against a sample of lines
+
+class FormatDetector {
+    std::vector<AccessLog*> candidates;
+    std::vector<int> scores;
+
+    std::vector<std::string> lines;
+    std::vector<int> error_stages;
+public:
+    FormatDetector();
+    ~FormatDetector();
+
+    void addLine(const std::string& line);
+
+    size_t size() const { return lines.size(); };
+
+    // true if any format parsed any sampled line
+    bool matched() const;
+
+    // index of the best scoring format or -1
+    int best() const;
+
+    // hands over the instance of the best scoring format
+    AccessLog* commit();
+
+    const std::vector<std::string>& getLines() const { return lines; };
+
+    // furthest stage any format reached on a sampled line
+    int getErrorStage(size_t i) const { return error_stages[i]; };
+
+    void clear();
+};
+
+// remembers the format detected for a log file so later runs on the same
+// file can skip detection. Files are identified by device, inode and a hash
+// of their first line, which survive the file being appended to.
+
+class FormatCache {
+    std::string cache_dir;
+    std::string cache_file;
+
+    std::vector<std::pair<std::string,std::string> > read();
+    void write(const std::vector<std::pair<std::string,std::string> >& entries);
+public:
+    FormatCache();
+
+    static std::string fileKey(const std::string& logfile);
+
+    std::string lookup(const std::string& key);
+    void store(const std::string& key, const std::string& format);
+    void forget(const std::string& key);
+};
+
+#endif
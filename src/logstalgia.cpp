@@ -23,29 +23,14 @@
 #include "core/png_writer.h"
 #include "core/timezone.h"
 
-//Logstalgia
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
-//turn performance profiling
-//#define LS_PERFORMANCE_PROFILE
+//Logstalgia
 
 bool  gSyncLog  = false;
 
-std::string profile_name;
-Uint32 profile_start_msec;
-
-void profile_start(std::string profile) {
-#ifdef LS_PERFORMANCE_PROFILE
-    profile_start_msec = SDL_GetTicks();
-    profile_name = profile;
-#endif
-}
-
-void profile_stop() {
-#ifdef LS_PERFORMANCE_PROFILE
-    debugLog("%s took %d ms\n", profile_name.c_str(), SDL_GetTicks() - profile_start_msec);
-#endif
-}
-
 void logstalgia_info(std::string msg) {
     SDLAppInfo(msg);
 }
@@ -66,22 +51,68 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
 
     highscore = 0;
 
+    aggregate_balls = false;
+
+    //zones are recorded by the profiler
+    if(tracer.isEnabled()) profiler.setEnabled(true);
+
     message_timer = 0.0f;
 
     ipSummarizer  = 0;
 
     mintime       = settings.sync ? time(0) : settings.start_time;
+
+    reorder_buffer.setWindow(settings.reorder_window);
+
+    //simulate the preroll period before the start time without recording it
+    preroll_remaining = settings.preroll;
+
+    if(mintime != 0 && !settings.sync) {
+        mintime -= (time_t) settings.preroll;
+    }
+
+    //lowered to where the --to time is in the log by findTimeRange()
+    stop_position = settings.stop_position;
     seeklog       = 0;
     streamlog     = 0;
+    followlog     = 0;
+    compiledlog   = 0;
 
-    if(logfile.empty()) {
+    if(logfile.empty() && settings.listen_endpoint.empty()) {
         throw SDLAppException("no file supplied");
     }
 
-    if(logfile == "-") {
-        streamlog = new StreamLog();
+    if(!settings.listen_endpoint.empty()) {
+        try {
+            streamlog = new SyslogLog(settings.listen_endpoint);
+
+        } catch(SyslogException& exception) {
+            throw SDLAppException("%s", exception.what());
+        }
+
         settings.disable_progress = true;
 
+    } else if(logfile == "-") {
+        streamlog = new StdinLog();
+        settings.disable_progress = true;
+
+    } else if(settings.follow) {
+        try {
+            //with --sync only lines written from now on are of interest
+            followlog = new FollowLog(logfile, settings.sync);
+
+        } catch(SeekLogException& exception) {
+            throw SDLAppException("unable to read log file");
+        }
+
+    } else if(CompiledLog::isCompiledLog(logfile)) {
+        try {
+            compiledlog = new CompiledLog(logfile);
+
+        } catch(CompiledLogException& exception) {
+            throw SDLAppException("%s", exception.what());
+        }
+
     } else {
         try {
             seeklog = new SeekLog(logfile);
@@ -98,17 +129,22 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
 
     background = vec3(0.0, 0.0, 0.0);
 
-    fontLarge  = fontmanager.grab("FreeSerif.ttf", 42);
-    fontMedium = fontmanager.grab("FreeMonoBold.ttf", 16);
-    fontBall   = fontmanager.grab("FreeMonoBold.ttf", 16);
-    fontSmall  = fontmanager.grab("FreeMonoBold.ttf", settings.font_size);
+    //fonts and textures need a GL context and are only used for drawing
+    if(!settings.no_display) {
+        fontLarge  = fontmanager.grab("FreeSerif.ttf", 42);
+        fontMedium = fontmanager.grab("FreeMonoBold.ttf", 16);
+        fontBall   = fontmanager.grab("FreeMonoBold.ttf", 16);
+        fontSmall  = fontmanager.grab("FreeMonoBold.ttf", settings.font_size);
 
-    fontLarge.dropShadow(true);
-    fontMedium.dropShadow(true);
-    fontSmall.dropShadow(true);
+        fontLarge.dropShadow(true);
+        fontMedium.dropShadow(true);
+        fontSmall.dropShadow(true);
 
-    balltex  = texturemanager.grab("ball.tga");
-    glowtex = texturemanager.grab("glow.tga");
+        balltex  = texturemanager.grab("ball.tga");
+        glowtex = texturemanager.grab("glow.tga");
+    } else {
+        balltex = glowtex = 0;
+    }
 
     infowindow = TextArea(fontSmall);
 
@@ -118,14 +154,74 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
     frameExporter = 0;
     framecount = 0;
     frameskip = 0;
+    frames_exported = 0;
     fixed_tick_rate = 0.0;
 
     accesslog = 0;
 
+    format_detector = 0;
+    format_cached   = false;
+
+    //entries of a compiled log are already parsed
+    if(compiledlog != 0) {
+
+        accesslog = new CompiledAccessLog(compiledlog);
+
+    } else if(settings.log_format == "json" || !settings.json_fields.empty()) {
+
+        JSONLog* jsonlog = new JSONLog(settings.json_fields);
+
+        if(!jsonlog->isValid()) {
+            std::string error = jsonlog->getError();
+            delete jsonlog;
+            throw SDLAppException("invalid json-fields: %s", error.c_str());
+        }
+
+        accesslog = jsonlog;
+
+    } else if(!settings.log_format.empty()) {
+
+        FormatLog* formatlog = new FormatLog(settings.log_format);
+
+        if(!formatlog->isValid()) {
+            std::string error = formatlog->getError();
+            delete formatlog;
+            throw SDLAppException("invalid log-format: %s", error.c_str());
+        }
+
+        accesslog = formatlog;
+
+    //use the format detected by a previous run on this file. without a
+    //display (--benchmark, --compile-log) the cache is neither used nor updated
+    } else if(seeklog != 0 || followlog != 0) {
+        if(!settings.no_display) format_key = FormatCache::fileKey(logfile);
+
+        std::string format = format_cache.lookup(format_key);
+
+        if(!format.empty() && (accesslog = createAccessLog(format)) != 0) {
+            debugLog("using cached %s log format", format.c_str());
+            format_cached = true;
+        }
+    }
+
     font_alpha = 1.0;
 
     take_screenshot = false;
 
+    lines_read      = 0;
+    entries_spawned = 0;
+    entries_sampled = 0;
+    ball_updates    = 0;
+    readlog_ticks   = 0;
+    summarize_ticks = 0;
+
+    last_frame_ticks = 0;
+
+    ingest_latency       = 0.0;
+    ingest_latency_max   = 0.0;
+    ingest_latency_total = 0.0;
+    ingest_latency_count = 0;
+
     //every 60 minutes seconds blank text for 60 seconds
 
     screen_blank_interval = 3600.0;
@@ -136,7 +232,23 @@ Logstalgia::Logstalgia(const std::string& logfile) : SDLApp() {
 }
 
 Logstalgia::~Logstalgia() {
+
+    if(parse_errors.getTotal() > 0) {
+        debugLog("%ld lines could not be parsed", parse_errors.getTotal());
+
+        for(int i=0; i<PARSE_STAGES; i++) {
+            if(parse_errors.getCount(i) > 0) debugLog("  %s: %ld", ParseErrors::stageName(i), parse_errors.getCount(i));
+        }
+
+        debugLog("examples:");
+
+        for(const std::string& sample : parse_errors.getSamples()) {
+            debugLog("  %s", sample.c_str());
+        }
+    }
+
     if(accesslog!=0) delete accesslog;
+    if(format_detector!=0) delete format_detector;
 
     for(auto& it: paddles) {
         delete it.second;
@@ -145,6 +257,8 @@ Logstalgia::~Logstalgia() {
 
     if(seeklog!=0) delete seeklog;
     if(streamlog!=0) delete streamlog;
+    if(followlog!=0) delete followlog;
+    if(compiledlog!=0) delete compiledlog;
 
     for(auto& it : summarizer_types) {
         if(it.second != 0) delete it.second;
@@ -187,6 +301,12 @@ void Logstalgia::keyPress(SDL_KeyboardEvent *e) {
 
         if(e->keysym.sym == SDLK_q) {
             info = !info;
+            profiler.setEnabled(info || tracer.isEnabled());
+        }
+
+        if(e->keysym.sym == SDLK_t && tracer.isEnabled()) {
+            std::string tracefile = tracer.dump(settings.trace_seconds);
+            setMessage("Wrote trace %s", tracefile.c_str());
         }
 
         if(e->keysym.sym == SDLK_c) {
@@ -197,6 +317,10 @@ void Logstalgia::keyPress(SDL_KeyboardEvent *e) {
             next = true;
         }
 
+        if(e->keysym.sym == SDLK_b) {
+            rewind(KEYFRAME_REWIND);
+        }
+
         if (e->keysym.sym == SDLK_p) {
             if(GLEW_VERSION_2_0) {
                 settings.ffp = !settings.ffp;
@@ -290,6 +414,7 @@ void Logstalgia::reset() {
 
     initPaddles();
     initRequestBalls();
+    releaseStrings(true);
 
     ipSummarizer->recalc_display();
 
@@ -297,15 +422,23 @@ void Logstalgia::reset() {
         s->recalc_display();
     }
 
-    for(LogEntry* l : queued_entries) {
-        delete l;
-    }
     queued_entries.clear();
+    reorder_buffer.clear();
+
+    pending_lines.clear();
+    format_unverified.clear();
+
+    if(format_detector != 0) format_detector->clear();
+
+    sampler.reset();
 
     // reset settings
     elapsed_time  = 0;
-    starttime     = 0;
     lasttime      = 0;
+
+    // when recording a fixed number of frames start the clock at the requested
+    // time rather than the first entry, so separately rendered segments line up
+    starttime     = (settings.output_frames > 0) ? mintime : 0;
 }
 
 void Logstalgia::screenshot() {
@@ -351,13 +484,242 @@ void Logstalgia::seekTo(float percent) {
     //disable pause if enabled before seeking
     if(paused) paused = false;
 
+    //go back to a time already played from its keyframe
+    LogEntry target;
+
+    if(entryAt(percent, target) && restoreKeyframe(target.timestamp)) return;
+
     reset();
 
-    seeklog->seekTo(percent);
+    if(settings.warmup > 0.0f) warmUp(percent);
+
+    seekLog(percent);
 
     readLog();
 }
 
+//restore the keyframe shortly before a time and simulate forward to it
+//without drawing. returns false if there isn't a keyframe close enough
+bool Logstalgia::restoreKeyframe(time_t time) {
+
+    time_t lead = std::max((time_t) KEYFRAME_LEAD, ballLifetime());
+
+    const Keyframe* keyframe = keyframes.before(time - lead);
+
+    if(keyframe == 0 || keyframe->time < time - KEYFRAME_MAX_REPLAY) return false;
+
+    ProfileScope profile("restoreKeyframe");
+
+    //reading the log adds keyframes
+    Keyframe restored = *keyframe;
+
+    reset();
+
+    if(settings.warmup > 0.0f) warmUp(restored.position);
+
+    seekLog(restored.position);
+
+    readLog();
+
+    highscore = restored.highscore;
+
+    //simulate in larger steps than a frame, and for at most as many ticks as
+    //the replay needs so it ends even if no entries arrive
+    float dt = KEYFRAME_REPLAY_STEP / settings.simulation_speed;
+
+    int max_ticks = (int) ((time - restored.time) / KEYFRAME_REPLAY_STEP) + 1;
+
+    for(int i=0; i<max_ticks && !end_reached && !appFinished; i++) {
+        if(starttime != 0 && starttime + (time_t) elapsed_time >= time) break;
+
+        logic(runtime, dt);
+    }
+
+    debugLog("restored keyframe %ld seconds before", (long) (time - restored.time));
+
+    return true;
+}
+
+//seconds of log a ball takes to cross the screen and come back
+time_t Logstalgia::ballLifetime() const {
+    return (time_t) ceilf(2.0f / settings.pitch_speed);
+}
+
+//go back a number of seconds
+void Logstalgia::rewind(int seconds) {
+
+    if(settings.disable_progress) return;
+
+    if(paused) paused = false;
+
+    time_t time = currtime - seconds;
+
+    if(restoreKeyframe(time)) return;
+
+    //not played from there before this session
+    seekTo(findPosition(time, logPercent()));
+}
+
+void Logstalgia::seekLog(float percent) {
+    if(followlog != 0) followlog->seekTo(percent);
+    else if(compiledlog != 0) compiledlog->seekTo(percent);
+    else seeklog->seekTo(percent);
+}
+
+float Logstalgia::logPercent() {
+    if(followlog != 0) return followlog->getPercent();
+    if(compiledlog != 0) return compiledlog->getPercent();
+    return seeklog->getPercent();
+}
+
+//parse the first entry at or after a position in the log
+bool Logstalgia::entryAt(float percent, LogEntry& le) {
+
+    if((seeklog == 0 && followlog == 0 && compiledlog == 0) || accesslog == 0 || percent >= 1.0) return false;
+
+    std::string linestr;
+
+    bool found;
+
+    if(followlog != 0)        found = followlog->getNextLineAt(linestr, percent);
+    else if(compiledlog != 0) found = compiledlog->getNextLineAt(linestr, percent);
+    else                      found = seeklog->getNextLineAt(linestr, percent);
+
+    if(!found) return false;
+
+    set_utc_tz();
+
+    bool parsed = accesslog->parseLine(linestr, le);
+
+    unset_utc_tz();
+
+    return parsed;
+}
+
+//binary search for the position of the first entry at or after a time
+//before position 'high'. returns a position just before that entry, or
+//with 'after' just after it. lines that can't be parsed are treated as later
+float Logstalgia::findPosition(time_t timestamp, float high, bool after) {
+
+    float low = 0.0f;
+
+    LogEntry le;
+
+    //stop when within a few KB of large logs
+    for(int i=0; i<24 && high - low > 1e-6; i++) {
+        float middle = (low + high) * 0.5f;
+
+        if(entryAt(middle, le) && le.timestamp < timestamp) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return after ? high : low;
+}
+
+//find where the --from and --to times are in the log by binary search, so
+//entries before the start time are skipped without parsing them and
+//reading stops at the end time
+void Logstalgia::findTimeRange() {
+
+    if(settings.sync || (seeklog == 0 && compiledlog == 0 && followlog == 0)) return;
+
+    if(mintime == 0 && settings.stop_time == 0) return;
+
+    //probing lines needs the format
+    if(accesslog == 0 && !detectFormat()) return;
+
+    //entries can be this far out of order
+    time_t window = reorder_buffer.getWindow();
+
+    if(settings.stop_time != 0) {
+        stop_position = std::min(stop_position, findPosition(settings.stop_time + window, 1.0f, true));
+    }
+
+    if(mintime != 0) {
+        float position = findPosition(mintime - window, 1.0f);
+
+        if(position > 0.0f) {
+            //lines sampled to detect the format are from the start of the log
+            pending_lines.clear();
+
+            seekLog(position);
+        }
+
+        debugLog("start time found at %.6f, end time at %.6f", position, stop_position);
+    }
+}
+
+//read the entries in the warmup period before a position straight into the
+//summarizers, so they look as they would have had the log played up to it
+void Logstalgia::warmUp(float percent) {
+
+    ProfileScope profile("warmUp");
+
+    LogEntry target;
+
+    if(!entryAt(percent, target)) return;
+
+    float warmup_position = findPosition(target.timestamp - (time_t) settings.warmup, percent);
+
+    seekLog(warmup_position);
+
+    std::string linestr;
+
+    long entries = 0;
+
+    set_utc_tz();
+
+    while(logPercent() < percent && nextLine(linestr)) {
+
+        LogEntry le;
+
+        if(!accesslog->parseLine(linestr, le) || le.timestamp >= target.timestamp) continue;
+
+        if(getGroupSummarizer(&le) == 0) continue;
+
+        addStrings(&le);
+        entries++;
+
+        //warmup entries leave the summarizers over the same period after the
+        //position sought to, as entries shown since then take their place
+        holdStrings(le, le.timestamp + (time_t) settings.warmup);
+    }
+
+    unset_utc_tz();
+
+    if(entries == 0) return;
+
+    ipSummarizer->summarize();
+
+    for(Summarizer* s : summarizers) {
+        s->summarize();
+    }
+
+    debugLog("warmed up summarizers with %ld entries", entries);
+}
+
+//keep the strings of an entry summarized without a ball until they expire
+void Logstalgia::holdStrings(const LogEntry& le, time_t expires) {
+
+    HeldStrings held;
+    held.expires  = expires;
+    held.hostname = le.hostname;
+    held.path     = le.path;
+
+    held_strings.push(held);
+}
+
+void Logstalgia::releaseStrings(bool all) {
+
+    while(!held_strings.empty() && (all || held_strings.top().expires <= currtime)) {
+        removeStrings(held_strings.top().hostname, held_strings.top().path);
+        held_strings.pop();
+    }
+}
+
 void Logstalgia::mouseClick(SDL_MouseButtonEvent *e) {
 
     if(e->type != SDL_MOUSEBUTTONDOWN) return;
@@ -378,33 +740,18 @@ std::string Logstalgia::dateAtPosition(float percent) {
 
     std::string date;
 
-    if(seeklog == 0 || accesslog == 0) return date;
+    LogEntry le;
 
-    //get line at position
-
-    std::string linestr;
-
-    if(percent<1.0 && seeklog->getNextLineAt(linestr, percent)) {
-
-        LogEntry le;
+    if(entryAt(percent, le)) {
+        //display date
+        char datestr[256];
 
-        set_utc_tz();
+        time_t timestamp = le.timestamp;
 
-        bool parsed = accesslog->parseLine(linestr, le);
-
-        unset_utc_tz();
-
-        if(parsed) {
-            //display date
-            char datestr[256];
-
-            time_t timestamp = le.timestamp;
-
-            struct tm* timeinfo = localtime ( &timestamp );
-            strftime(datestr, 256, "%H:%M:%S %B %d, %Y", timeinfo);
-            date = std::string(datestr);
-        }
-     }
+        struct tm* timeinfo = localtime ( &timestamp );
+        strftime(datestr, 256, "%H:%M:%S %B %d, %Y", timeinfo);
+        date = std::string(datestr);
+    }
 
     return date;
 }
@@ -488,13 +835,16 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
     //find appropriate summarizer for url
     Summarizer* groupSummarizer = getGroupSummarizer(le);
 
-    if(!groupSummarizer) return;
+    if(!groupSummarizer) {
+        delete le;
+        return;
+    }
 
     Paddle* entry_paddle = 0;
 
     if(settings.paddle_mode > PADDLE_SINGLE) {
 
-        std::string paddle_token = (settings.paddle_mode == PADDLE_VHOST) ? le->vhost : le->pid;
+        std::string paddle_token = getPaddleToken(le);
 
         entry_paddle = paddles[paddle_token];
 
@@ -523,6 +873,20 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
     vec2 ball_start = vec2(start_x, pos_y);
     vec2 ball_dest  = vec2(entry_paddle->getX(), dest_y);
 
+    BallBucket bucket;
+
+    if(aggregate_balls) {
+        bucket = BallBucket(groupSummarizer, groupSummarizer->getBestMatchIndex(pageurl),
+                            ipSummarizer->getBestMatchIndex(hostname), entry_paddle, le->successful);
+
+        auto it = ball_buckets.find(bucket);
+
+        if(it != ball_buckets.end()) {
+            it->second->merge(le);
+            return;
+        }
+    }
+
     const std::string& match = ipSummarizer->getBestMatchStr(hostname);
 
     vec3 colour = groupSummarizer->isColoured() ? groupSummarizer->getColour() : colourHash(match);
@@ -530,102 +894,249 @@ void Logstalgia::addBall(LogEntry* le, float start_offset) {
     RequestBall* ball = new RequestBall(le, colour, ball_start, ball_dest);
 
     balls.push_back(ball);
+
+    if(aggregate_balls) ball_buckets[bucket] = ball;
+}
+
+//the field of the entry that selects its paddle in multi-paddle modes
+const std::string& Logstalgia::getPaddleToken(LogEntry* le) {
+
+    switch(settings.paddle_mode) {
+        case PADDLE_VHOST:
+            return le->vhost;
+        case PADDLE_UPSTREAM:
+            return le->upstream;
+        default:
+            return le->pid;
+    }
 }
 
 BaseLog* Logstalgia::getLog() {
     if(seeklog !=0) return seeklog;
+    if(followlog !=0) return followlog;
+    if(compiledlog !=0) return compiledlog;
 
     return streamlog;
 }
 
+//next line from the log with trailing whitespace removed
+bool Logstalgia::nextLine(std::string& line) {
+
+    if(!pending_lines.empty()) {
+        line = pending_lines.front();
+        pending_lines.pop_front();
+        return true;
+    }
+
+    if(!getLog()->getNextLine(line)) return false;
+
+    lines_read++;
+
+    //trim whitespace
+    if(line.size()>0) {
+        size_t string_end =
+            line.find_last_not_of(" \t\f\v\n\r");
+
+        if(string_end == std::string::npos) {
+            line = "";
+        } else if(string_end != line.size()-1) {
+            line = line.substr(0,string_end+1);
+        }
+    }
+
+    return true;
+}
+
+//sample lines until a format can be chosen. returns false if more input is needed
+bool Logstalgia::detectFormat() {
+
+    ProfileScope profile("detectFormat");
+
+    if(format_detector == 0) format_detector = new FormatDetector();
+
+    std::string linestr;
+
+    while(accesslog == 0) {
+
+        bool stalled = false;
+
+        while(format_detector->size() < FORMAT_DETECT_LINES) {
+            if(!nextLine(linestr)) {
+                stalled = true;
+                break;
+            }
+            format_detector->addLine(linestr);
+        }
+
+        if(format_detector->size() == 0) break;
+
+        //commit to the best format once the sample is full or the input
+        //runs dry, then replay the sampled lines through it
+        if(format_detector->matched()) {
+            accesslog = format_detector->commit();
+
+            const std::vector<std::string>& sampled = format_detector->getLines();
+            pending_lines.insert(pending_lines.begin(), sampled.begin(), sampled.end());
+
+            format_cache.store(format_key, accessLogFormats()[format_detector->best()].name);
+            break;
+        }
+
+        //keep waiting for a recognizable line on a stream
+        if(stalled && (streamlog != 0 || followlog != 0)) break;
+
+        //nothing recognized the sample
+        const std::vector<std::string>& sampled = format_detector->getLines();
+
+        for(size_t i=0; i<sampled.size(); i++) {
+            parse_errors.add(format_detector->getErrorStage(i), sampled[i]);
+        }
+
+        format_detector->clear();
+
+        if(stalled) break;
+    }
+
+    if(accesslog != 0) {
+        delete format_detector;
+        format_detector = 0;
+    }
+
+    return accesslog != 0;
+}
+
 void Logstalgia::readLog(int buffer_rows) {
 
-    profile_start("readLog");
+    ProfileScope profile("readLog");
+
+    Uint64 read_start = profiler_ticks();
 
     set_utc_tz();
 
     int entries_read = 0;
 
     std::string linestr;
-    BaseLog* baselog = getLog();
 
     time_t read_timestamp = 0;
 
-    while( baselog->getNextLine(linestr) ) {
+    //the position of the first entry read is kept as a keyframe
+    float keyframe_position = -1.0f;
 
-        //trim whitespace
-        if(linestr.size()>0) {
-            size_t string_end =
-                linestr.find_last_not_of(" \t\f\v\n\r");
+    if(!settings.disable_progress && accesslog != 0 && pending_lines.empty() && (seeklog != 0 || compiledlog != 0 || followlog != 0)) {
+        keyframe_position = logPercent();
+    }
 
-            if(string_end == std::string::npos) {
-                linestr = "";
-            } else if(string_end != linestr.size()-1) {
-                linestr = linestr.substr(0,string_end+1);
-            }
+    while(true) {
+
+        if(accesslog == 0 && !detectFormat()) break;
+
+        bool end_of_input = !nextLine(linestr);
+
+        //a cached format that parsed nothing before the end of the file
+        //is not trusted either
+        if(end_of_input && !(format_cached && seeklog != 0 && !format_unverified.empty())) {
+            //nothing later is coming to reorder entries still held against.
+            //live input is instead released as the clock passes it
+            if(!settings.sync) reorder_buffer.flush(queued_entries);
+            break;
         }
 
         LogEntry le;
 
         bool parsed_entry;
+        int error_stage = PARSE_STAGE_PREFILTER;
 
-        //determine format
-        if(accesslog==0) {
+        if(end_of_input) {
+            parsed_entry = false;
+        } else if(!(parsed_entry = accesslog->parseLine(linestr, le))) {
+            error_stage = accesslog->getErrorStage();
+        }
 
-            //is this a recognized NCSA access log?
-            NCSALog* ncsalog = new NCSALog();
-            if((parsed_entry = ncsalog->parseLine(linestr, le))) {
-                accesslog = ncsalog;
-            } else {
-                delete ncsalog;
-            }
+        if(format_cached) {
 
-            if(accesslog==0) {
-                //is this a custom log?
-                CustomAccessLog* customlog = new CustomAccessLog();
-                if((parsed_entry = customlog->parseLine(linestr, le))) {
-                    accesslog = customlog;
-                } else {
-                    delete customlog;
+            if(parsed_entry) {
+                //the cached format is confirmed
+                for(auto& rejected : format_unverified) {
+                    parse_errors.add(rejected.first, rejected.second);
                 }
-            }
+                format_unverified.clear();
+                format_cached = false;
 
-        } else {
+            } else {
+                if(!end_of_input) format_unverified.push_back(std::make_pair(error_stage, linestr));
+
+                //the file no longer matches its cached format, detect it again
+                if(format_unverified.size() >= FORMAT_DETECT_LINES || end_of_input) {
+                    debugLog("cached log format did not match, detecting format");
+
+                    format_cache.forget(format_key);
+
+                    for(auto it = format_unverified.rbegin(); it != format_unverified.rend(); it++) {
+                        pending_lines.push_front(it->second);
+                    }
+                    format_unverified.clear();
+                    format_cached = false;
+
+                    delete accesslog;
+                    accesslog = 0;
+                }
 
-            if(!(parsed_entry = accesslog->parseLine(linestr, le))) {
-                debugLog("error: could not read line %s\n", linestr.c_str());
+                continue;
             }
         }
 
+        if(!parsed_entry) parse_errors.add(error_stage, linestr);
+
         if(parsed_entry) {
 
+            if(streamlog != 0) le.received = streamlog->lastReceived();
+
             if((!mintime || mintime <= le.timestamp) && (!settings.stop_time || settings.stop_time > le.timestamp)) {
 
-                queued_entries.push_back(new LogEntry(le));
+                if(reorder_buffer.getWindow() > 0) {
+                    reorder_buffer.push(le);
+                    reorder_buffer.release(queued_entries);
+                } else {
+                    queued_entries.push(le);
+                }
+
+                if(keyframe_position >= 0.0f) {
+                    keyframes.add(le.timestamp, keyframe_position, highscore);
+                    keyframe_position = -1.0f;
+                }
 
                 total_entries++;
                 entries_read++;
 
                 //read at least the buffered row count if specified
                 //otherwise read all entries with the same time
+                //lines already received on STDIN are all taken so bursts
+                //don't build up latency. StdinLog bounds how many can be waiting
                 if(buffer_rows) {
-                    if(entries_read > buffer_rows) break;
-                } else {
-                    if(read_timestamp && read_timestamp < le.timestamp) break;
-                }
+                    if(entries_read > buffer_rows && streamlog == 0) break;
+                } else if(!queued_entries.empty()) {
+                    //entries held for reordering don't count until released
+                    time_t queued_timestamp = queued_entries.back().timestamp;
+
+                    if(read_timestamp && read_timestamp < queued_timestamp) break;
 
-                read_timestamp = le.timestamp;
+                    read_timestamp = queued_timestamp;
+                }
             }
         }
     }
 
-    profile_stop();
+    if(settings.sync && reorder_buffer.getWindow() > 0) {
+        reorder_buffer.release(queued_entries, time(0));
+    }
 
     unset_utc_tz();
 
-    if(queued_entries.empty() && seeklog != 0) {
+    readlog_ticks += profiler_ticks() - read_start;
+
+    if(queued_entries.empty() && reorder_buffer.empty() && (seeklog != 0 || compiledlog != 0)) {
 
-        if(total_entries==0) {
+        if(total_entries==0 && !settings.output_frames) {
             if(mintime != 0) {
                 logstalgia_quit("could not parse any entries in the specified time period");
             } else {
@@ -639,10 +1150,15 @@ void Logstalgia::readLog(int buffer_rows) {
         return;
     }
 
-    if(seeklog != 0) {
-        float percent = seeklog->getPercent();
+    //the end of a followed file keeps moving
+    if(followlog != 0 && !settings.disable_progress) {
+        slider.setPercent(followlog->getPercent());
+    }
+
+    if(seeklog != 0 || compiledlog != 0) {
+        float percent = seeklog != 0 ? seeklog->getPercent() : compiledlog->getPercent();
 
-        if(percent > settings.stop_position) {
+        if(percent > stop_position) {
             end_reached = true;
             return;
         }
@@ -652,7 +1168,7 @@ void Logstalgia::readLog(int buffer_rows) {
 
     //set start time if currently 0
     if(starttime==0 && !queued_entries.empty()) {
-        starttime = queued_entries.front()->timestamp;
+        starttime = queued_entries.front().timestamp;
         currtime  = 0;
     }
 }
@@ -664,6 +1180,8 @@ void Logstalgia::init() {
 
     reset();
 
+    if(settings.start_position == 0.0f) findTimeRange();
+
     readLog();
 
     //add default groups
@@ -681,7 +1199,7 @@ void Logstalgia::init() {
 
     resizeGroups();
 
-    SDL_ShowCursor(false);
+    if(!settings.no_display) SDL_ShowCursor(false);
 
     //set start position
     if(settings.start_position > 0.0 && settings.start_position < 1.0) {
@@ -755,7 +1273,7 @@ void Logstalgia::setBackground(vec3 background) {
     this->background = background;
 }
 
-void Logstalgia::setFrameExporter(FrameExporter* exporter) {
+void Logstalgia::setFrameExporter(AsyncFrameExporter* exporter) {
 
     int fixed_framerate = settings.output_framerate;
     int video_framerate = fixed_framerate;
@@ -774,28 +1292,216 @@ void Logstalgia::setFrameExporter(FrameExporter* exporter) {
     this->frameExporter = exporter;
 }
 
+// render frames back to back without a window or event loop
+// (video export only, so time is driven entirely by the fixed tick rate)
+void Logstalgia::runHeadless() {
+
+    init();
+
+    float t = 0.0f;
+
+    while(!appFinished) {
+        t += fixed_tick_rate;
+        update(t, fixed_tick_rate);
+    }
+}
+
+// run the simulation over the whole log as fast as possible at a fixed tick
+// without drawing, then print throughput statistics as JSON
+void Logstalgia::runBenchmark() {
+
+    float dt = 1.0f / 60.0f;
+
+    Uint64 start_ticks = profiler_ticks();
+
+    init();
+
+    long ticks = 0;
+
+    while(!appFinished) {
+        runtime += dt;
+        logic(runtime, dt);
+        ticks++;
+    }
+
+    double seconds        = (profiler_ticks() - start_ticks) / (double) profiler_ticks_per_second();
+    double readlog_secs   = readlog_ticks   / (double) profiler_ticks_per_second();
+    double summarize_secs = summarize_ticks / (double) profiler_ticks_per_second();
+
+    if(seconds <= 0.0) seconds = 1e-9;
+
+    long peak_rss_kb = 0;
+
+#ifndef _WIN32
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+        peak_rss_kb = usage.ru_maxrss;
+#endif
+    }
+#endif
+
+    printf("{\n");
+    printf("  \"ticks\": %ld,\n", ticks);
+    printf("  \"tick_seconds\": %.6f,\n", dt);
+    printf("  \"simulated_seconds\": %.0f,\n", elapsed_time);
+    printf("  \"wall_seconds\": %.3f,\n", seconds);
+    printf("  \"lines_read\": %ld,\n", lines_read);
+    printf("  \"lines_per_second\": %.0f,\n", lines_read / seconds);
+    printf("  \"readlog_ms\": %.3f,\n", readlog_secs * 1000.0);
+    printf("  \"entries_spawned\": %ld,\n", entries_spawned);
+    printf("  \"entries_per_second\": %.0f,\n", entries_spawned / seconds);
+    printf("  \"summarize_ms\": %.3f,\n", summarize_secs * 1000.0);
+    printf("  \"ball_updates\": %ld,\n", ball_updates);
+    printf("  \"ball_updates_per_second\": %.0f,\n", ball_updates / seconds);
+    printf("  \"parse_errors\": %ld,\n", parse_errors.getTotal());
+
+    for(int i=0; i<PARSE_STAGES; i++) {
+        printf("  \"parse_errors_%s\": %ld,\n", ParseErrors::stageName(i), parse_errors.getCount(i));
+    }
+
+    printf("  \"peak_rss_kb\": %ld\n", peak_rss_kb);
+    printf("}\n");
+}
+
+//parse the log once and write its entries to a compiled log
+void Logstalgia::compileLog(const std::string& output) {
+
+    Uint64 start_ticks = profiler_ticks();
+
+    uint64_t entries = 0;
+
+    try {
+        LogCompiler compiler(output);
+
+        if(settings.start_position > 0.0 && settings.start_position < 1.0) {
+            if(seeklog != 0) seeklog->seekTo(settings.start_position);
+            else if(compiledlog != 0) compiledlog->seekTo(settings.start_position);
+        } else {
+            findTimeRange();
+        }
+
+        while(!end_reached) {
+            readLog(10000);
+
+            for(size_t i=0; i<queued_entries.size(); i++) {
+                compiler.add(queued_entries[i]);
+            }
+
+            queued_entries.clear();
+        }
+
+        compiler.finish();
+
+        entries = compiler.getEntries();
+
+    } catch(CompiledLogException& exception) {
+        throw SDLAppException("%s", exception.what());
+    }
+
+    double seconds = (profiler_ticks() - start_ticks) / (double) profiler_ticks_per_second();
+
+    printf("compiled %llu entries from %ld lines to %s in %.1f seconds\n", (unsigned long long) entries, lines_read, output.c_str(), seconds);
+}
+
 void Logstalgia::update(float t, float dt) {
 
+    profiler.beginFrame();
+
     //if exporting a video use a fixed tick rate rather than time based
     if(frameExporter != 0) {
         dt = fixed_tick_rate;
     }
 
+    //simulate the preroll period up front without drawing or recording it
+    if(preroll_remaining > 0.0f) {
+
+        float preroll_dt = (fixed_tick_rate > 0.0f) ? fixed_tick_rate : 1.0f / 60.0f;
+
+        while(preroll_remaining > 0.0f && !appFinished) {
+            runtime += preroll_dt;
+            logic(runtime, preroll_dt);
+            preroll_remaining -= preroll_dt * settings.simulation_speed;
+        }
+    }
+
     //have to manage runtime internally as we're messing with dt
     runtime += dt;
 
-    logic(runtime, dt);
-    draw(runtime, dt);
+    {
+        ProfileScope profile("logic");
+        logic(runtime, dt);
+    }
+
+    {
+        ProfileScope profile("draw");
+        draw(runtime, dt);
+    }
 
     //extract frames based on frameskip setting
     //if frameExporter defined
     if(frameExporter != 0) {
         if(framecount % (frameskip+1) == 0) {
-            frameExporter->dump();
+            ProfileScope profile("export");
+
+            try {
+                frameExporter->dump();
+            } catch(ExporterException& exception) {
+                throw SDLAppException("could not write to '%s'", exception.what());
+            }
+            frames_exported++;
+
+            if(settings.output_frames > 0 && frames_exported >= settings.output_frames) {
+                appFinished = true;
+            }
         }
     }
 
    framecount++;
+
+   publishMetrics();
+
+   profiler.endFrame();
+}
+
+// make counters available to the metrics server thread
+void Logstalgia::publishMetrics() {
+
+    Uint64 frame_ticks = profiler_ticks();
+
+    if(last_frame_ticks != 0) {
+        metrics.recordFrame((frame_ticks - last_frame_ticks) / (double) profiler_ticks_per_second());
+    }
+
+    last_frame_ticks = frame_ticks;
+
+    metrics.fps               = fps;
+    metrics.queue_depth       = queued_entries.size();
+    metrics.balls             = balls.size();
+    metrics.paddles           = paddles.size();
+    metrics.lines_read        = lines_read;
+    metrics.entries_spawned   = entries_spawned;
+    metrics.entries_sampled   = entries_sampled;
+    metrics.sampling_denominator = sampler.getDenominator();
+    for(int i=0; i<PARSE_STAGES; i++) {
+        metrics.parse_errors[i] = parse_errors.getCount(i);
+    }
+    metrics.summarize_seconds = summarize_ticks / (double) profiler_ticks_per_second();
+
+    metrics.ingest_latency_seconds = ingest_latency_total;
+    metrics.ingest_latency_count   = ingest_latency_count;
+    metrics.ingest_latency_max     = ingest_latency_max;
+}
+
+void Logstalgia::recordIngestLatency(Uint64 received) {
+
+    ingest_latency = (profiler_ticks() - received) / (double) profiler_ticks_per_second();
+
+    ingest_latency_max    = std::max(ingest_latency_max, ingest_latency);
+    ingest_latency_total += ingest_latency;
+    ingest_latency_count++;
 }
 
 RequestBall* Logstalgia::findNearest(Paddle* paddle, const std::string& paddle_token) {
@@ -813,10 +1519,7 @@ RequestBall* Logstalgia::findNearest(Paddle* paddle, const std::string& paddle_t
         }
 
         if(le->successful && !ball->hasBounced()
-            && (   (settings.paddle_mode <= PADDLE_SINGLE)
-                || (settings.paddle_mode == PADDLE_VHOST && le->vhost == paddle_token)
-                || (settings.paddle_mode == PADDLE_PID   && le->pid   == paddle_token)
-               )
+            && (settings.paddle_mode <= PADDLE_SINGLE || getPaddleToken(le) == paddle_token)
             ) {
 
             float arrival = ball->arrivalTime();
@@ -831,12 +1534,14 @@ RequestBall* Logstalgia::findNearest(Paddle* paddle, const std::string& paddle_t
     return nearest;
 }
 
-void Logstalgia::removeBall(RequestBall* ball) {
+void Logstalgia::removeStrings(LogEntry* le) {
+    removeStrings(le->hostname, le->path);
+}
 
-    LogEntry* le = ball->getLogEntry();
+void Logstalgia::removeStrings(const std::string& hostname, const std::string& path) {
 
-    std::string url  = le->path;
-    std::string host = le->hostname;
+    std::string url  = path;
+    std::string host = hostname;
 
     for(Summarizer* s: summarizers) {
         if(s->supportedString(url)) {
@@ -848,6 +1553,15 @@ void Logstalgia::removeBall(RequestBall* ball) {
     }
 
     ipSummarizer->removeString(host);
+}
+
+void Logstalgia::removeBall(RequestBall* ball) {
+
+    removeStrings(ball->getLogEntry());
+
+    for(LogEntry* le : ball->getMergedEntries()) {
+        removeStrings(le);
+    }
 
     delete ball;
 }
@@ -873,7 +1587,8 @@ void Logstalgia::logic(float t, float dt) {
 
     infowindow.hide();
 
-    if(end_reached && balls.empty()) {
+    //keep recording empty frames if a fixed number of frames was requested
+    if(end_reached && balls.empty() && !settings.output_frames) {
         appFinished = true;
         return;
     }
@@ -904,13 +1619,13 @@ void Logstalgia::logic(float t, float dt) {
         return;
     }
 
+    if(settings.sync) sampler.frame(dt);
+
     //next will fast forward clock to the time of the next entry,
     //if the next entry is in the future
     if(next || (!settings.disable_auto_skip && balls.empty())) {
         if(!queued_entries.empty()) {
-            LogEntry* le = queued_entries.front();
-
-            long entrytime = le->timestamp;
+            long entrytime = queued_entries.front().timestamp;
             if(entrytime > currtime) {
                 elapsed_time = entrytime - starttime;
                 currtime = starttime + (long)(elapsed_time);
@@ -922,61 +1637,84 @@ void Logstalgia::logic(float t, float dt) {
     //recalc spawn speed each second by
     if(currtime != lasttime) {
 
+        releaseStrings();
+
         //dont bother reading the log if we dont need to
-        if(queued_entries.empty() || queued_entries.back()->timestamp <= currtime) {
+        if(queued_entries.empty() || queued_entries.back().timestamp <= currtime) {
             readLog();
         }
 
-        profile_start("determine new entries");
+        int items_to_spawn = queued_entries.countUntil(currtime);
 
-        int items_to_spawn=0;
+        {
+            ProfileScope profile("determine new entries");
 
-        for(LogEntry* le : queued_entries) {
-
-            if(le->timestamp > currtime) break;
-
-            items_to_spawn++;
-
-            addStrings(le);
+            for(int i=0; i<items_to_spawn; i++) {
+                addStrings(&(queued_entries[i]));
+            }
         }
 
-        profile_stop();
-
         //debugLog("items to spawn %d\n", items_to_spawn);
 
+        if(settings.sync) sampler.update(items_to_spawn);
+
         if(items_to_spawn > 0) {
 
-            profile_start("add new strings");
+            {
+                ProfileScope profile("summarize");
 
-            //re-summarize
-            ipSummarizer->summarize();
+                Uint64 summarize_start = profiler_ticks();
 
-            for(Summarizer* s : summarizers) {
-                s->summarize();
-            }
+                //re-summarize
+                ipSummarizer->summarize();
 
-            profile_stop();
+                for(Summarizer* s : summarizers) {
+                    s->summarize();
+                }
 
-            profile_start("add new entries");
+                summarize_ticks += profiler_ticks() - summarize_start;
+            }
 
-            float item_offset = 1.0 / (float) (items_to_spawn);
+            ProfileScope profile("add new entries");
 
-            int item_no = 0;
+            float item_offset = 1.0 / (float) (items_to_spawn);
 
-            while(!queued_entries.empty()) {
+            //over budget, merge similar requests in this batch into aggregate balls
+            aggregate_balls = settings.ball_budget > 0 && (balls.size() + items_to_spawn / sampler.getDenominator()) > (size_t) settings.ball_budget;
 
-                LogEntry* le = queued_entries.front();
+            for(int i=0; i<items_to_spawn; i++) {
 
-                if(le->timestamp > currtime) break;
+                const LogEntry& entry = queued_entries[i];
 
-                float pos_offset   = item_offset * (float) item_no++;
+                float pos_offset   = item_offset * (float) i;
                 float start_offset = std::min(1.0f, pos_offset);
 
-                addBall(le, start_offset);
+                //requests of hosts not shown still count towards the score
+                if(!sampler.keep(entry.hostname)) {
+                    highscore++;
+                    entries_sampled++;
+
+                    //for as long as its ball would have been on screen
+                    if(getGroupSummarizer(&(queued_entries[i])) != 0) {
+                        holdStrings(entry, entry.timestamp + ballLifetime());
+                    }
+
+                    continue;
+                }
+
+                //the ball takes its own copy, the slot is reused
+                addBall(new LogEntry(entry), start_offset);
 
-                queued_entries.pop_front();
+                entries_spawned++;
+
+                if(entry.received != 0) recordIngestLatency(entry.received);
             }
 
+            queued_entries.pop(items_to_spawn);
+
+            ball_buckets.clear();
+            aggregate_balls = false;
+
         }
 
         //update date
@@ -996,11 +1734,9 @@ void Logstalgia::logic(float t, float dt) {
         }
 
         lasttime=currtime;
-
-        profile_stop();
     } else {
         //do small reads per frame if we havent buffered the next second
-        if(queued_entries.empty() || queued_entries.back()->timestamp <= currtime+1) {
+        if(queued_entries.empty() || queued_entries.back().timestamp <= currtime+1) {
             readLog(50);
         }
     }
@@ -1022,8 +1758,7 @@ void Logstalgia::logic(float t, float dt) {
 
                 LogEntry* le = ball->getLogEntry();
 
-                if(   (settings.paddle_mode == PADDLE_VHOST && le->vhost == paddle_token)
-                   || (settings.paddle_mode == PADDLE_PID   && le->pid   == paddle_token)) {
+                if(getPaddleToken(le) == paddle_token) {
                     token_match = true;
                     break;
                 }
@@ -1053,32 +1788,36 @@ void Logstalgia::logic(float t, float dt) {
 
     retarget = false;
 
-    profile_start("check ball status");
+    {
+        ProfileScope profile("check ball status");
 
-    // NOTE: special handling for this iterator as items are being removed
-    for(auto it = balls.begin(); it != balls.end();) {
+        ball_updates += balls.size();
 
-        RequestBall* ball = *it;
+        // NOTE: special handling for this iterator as items are being removed
+        for(auto it = balls.begin(); it != balls.end();) {
 
-        highscore += ball->logic(sdt);
+            RequestBall* ball = *it;
 
-        if(ball->isFinished()) {
-            it = balls.erase(it);
-            removeBall(ball);
-        } else {
-            it++;
+            highscore += ball->logic(sdt);
+
+            if(ball->isFinished()) {
+                it = balls.erase(it);
+                removeBall(ball);
+            } else {
+                it++;
+            }
         }
     }
 
-    profile_stop();
-
-    profile_start("ipSummarizer logic");
-    ipSummarizer->logic(dt);
-    profile_stop();
+    {
+        ProfileScope profile("ipSummarizer logic");
+        ipSummarizer->logic(dt);
+    }
 
-    profile_start("updateGroups logic");
-    updateGroups(dt);
-    profile_stop();
+    {
+        ProfileScope profile("updateGroups logic");
+        updateGroups(dt);
+    }
 
 
     screen_blank_elapsed += dt;
@@ -1223,47 +1962,43 @@ void Logstalgia::draw(float t, float dt) {
     glDisable(GL_CULL_FACE);
     glDisable(GL_LIGHTING);
 
-    profile_start("draw ip summarizer");
-
-    ipSummarizer->draw(dt, font_alpha);
-
-    profile_stop();
-
-
-    profile_start("draw groups");
-
-    drawGroups(dt, font_alpha);
-
-    profile_stop();
+    {
+        ProfileScope profile("draw ip summarizer");
+        ipSummarizer->draw(dt, font_alpha);
+    }
 
+    {
+        ProfileScope profile("draw groups");
+        drawGroups(dt, font_alpha);
+    }
 
-    profile_start("draw balls");
+    {
+        ProfileScope profile("draw balls");
 
-    glEnable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glEnable(GL_TEXTURE_2D);
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glBindTexture(GL_TEXTURE_2D, balltex->textureid);
+        glBindTexture(GL_TEXTURE_2D, balltex->textureid);
 
-    for(RequestBall* ball : balls) {
-        ball->draw();
+        for(RequestBall* ball : balls) {
+            ball->draw();
+        }
     }
 
-    profile_stop();
-
-    profile_start("draw response codes");
+    {
+        ProfileScope profile("draw response codes");
 
-    for(std::list<RequestBall*>::iterator it = balls.begin(); it != balls.end(); it++) {
-        RequestBall* r = *it;
+        for(std::list<RequestBall*>::iterator it = balls.begin(); it != balls.end(); it++) {
+            RequestBall* r = *it;
 
-        if(!settings.hide_response_code && r->hasBounced()) {
-            r->drawResponseCode(&fontMedium);
+            if(!settings.hide_response_code && r->hasBounced()) {
+                r->drawResponseCode(&fontMedium);
+            }
         }
     }
 
-    profile_stop();
-
     glDisable(GL_TEXTURE_2D);
     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_BLEND);
@@ -1358,9 +2093,28 @@ void Logstalgia::draw(float t, float dt) {
         fontMedium.print(2,53,"Paddles: %d", paddles.size());
         fontMedium.print(2,70,"Simulation Speed: %.2f", settings.simulation_speed);
         fontMedium.print(2,87,"Pitch Speed: %.2f", settings.pitch_speed);
+        fontMedium.print(2,104,"Parse Errors: %ld", parse_errors.getTotal());
+
+        int info_y = 121;
+
+        if(streamlog != 0) {
+            fontMedium.print(2,info_y,"Latency: %.0f ms (max %.0f ms)", ingest_latency * 1000.0, ingest_latency_max * 1000.0);
+            info_y += 17;
+        }
+
+        if(sampler.isSampling()) {
+            fontMedium.print(2,info_y,"Showing 1/%d of hosts (%ld not shown)", sampler.getDenominator(), entries_sampled);
+            info_y += 17;
+        }
+
+        profiler.draw(fontMedium, 2, info_y + 17);
     } else {
         fontMedium.draw(2,2,  displaydate.c_str());
         fontMedium.draw(2,19, displaytime.c_str());
+
+        if(sampler.isSampling()) {
+            fontMedium.print(2,36, "Showing 1/%d of hosts", sampler.getDenominator());
+        }
     }
 
     fontLarge.setColour(vec4(1.0f,1.0f,1.0f,font_alpha));
@@ -21,7 +21,6 @@
 #include "core/sdlapp.h"
 #include "core/fxfont.h"
 #include "core/seeklog.h"
-#include "core/ppm.h"
 
 #include "logentry.h"
 #include "paddle.h"
@@ -29,13 +28,41 @@
 #include "summarizer.h"
 #include "textarea.h"
 #include "slider.h"
+#include "exporter.h"
+#include "profiler.h"
+#include "trace.h"
+#include "metrics.h"
+#include "logformat.h"
+#include "formatlog.h"
+#include "jsonlog.h"
+#include "followlog.h"
+#include "compiledlog.h"
+#include "stdinlog.h"
+#include "sysloglog.h"
+#include "sampler.h"
+#include "entryqueue.h"
+#include "reorderbuffer.h"
+#include "keyframes.h"
 
 #include <string>
 #include <vector>
 #include <list>
+#include <deque>
 #include <map>
+#include <tuple>
+#include <queue>
+#include <functional>
 #include <time.h>
 
+// strings added to the summarizers that are removed again once they expire
+struct HeldStrings {
+    time_t expires;
+    std::string hostname;
+    std::string path;
+
+    bool operator>(const HeldStrings& other) const { return expires > other.expires; };
+};
+
 class Logstalgia : public SDLApp {
 
     std::map<std::string,Paddle*> paddles;
@@ -57,6 +84,9 @@ class Logstalgia : public SDLApp {
 
     time_t mintime;
 
+    //position in the log reading stops after
+    float stop_position;
+
     time_t starttime;
     time_t currtime;
     time_t lasttime;
@@ -103,26 +133,98 @@ class Logstalgia : public SDLApp {
 
     AccessLog* accesslog;
 
+    //log format detection
+    FormatDetector* format_detector;
+    FormatCache format_cache;
+    std::string format_key;
+
+    //a format taken from the cache is trusted until it fails to parse the
+    //first sampled lines, which are held back in case detection is needed
+    bool format_cached;
+    std::vector<std::pair<int, std::string> > format_unverified;
+
+    //lines read from the log but not yet parsed
+    std::deque<std::string> pending_lines;
+
     SeekLog* seeklog;
-    StreamLog* streamlog;
+    BackgroundLog* streamlog;
+    FollowLog* followlog;
+    CompiledLog* compiledlog;
+
+    EntryQueue queued_entries;
+
+    //entries read out of order are held here until they can be queued in order
+    ReorderBuffer reorder_buffer;
 
-    std::list<LogEntry*> queued_entries;
+    //positions in the log of times already played
+    KeyframeIndex keyframes;
     std::list<RequestBall*> balls;
 
+    //live input arriving faster than it can be animated is sampled by host
+    HostSampler sampler;
+
+    //strings of entries summarized without a ball (read by warmUp() or not
+    //shown by the sampler), soonest to expire first
+    std::priority_queue<HeldStrings, std::vector<HeldStrings>, std::greater<HeldStrings> > held_strings;
+
+    //requests spawned together with the same source row, destination row and
+    //paddle share a ball when over the ball budget
+    typedef std::tuple<Summarizer*, int, int, Paddle*, bool> BallBucket;
+
+    std::map<BallBucket, RequestBall*> ball_buckets;
+    bool aggregate_balls;
+
     TextArea infowindow;
 
     float runtime;
     float fixed_tick_rate;
     int framecount;
     int frameskip;
-    FrameExporter* frameExporter;
+    int frames_exported;
+    float preroll_remaining;
+    AsyncFrameExporter* frameExporter;
+
+    //simulation counters reported by --benchmark
+    long   lines_read;
+    ParseErrors parse_errors;
+    long   entries_spawned;
+    long   entries_sampled;
+    long   ball_updates;
+    Uint64 readlog_ticks;
+    Uint64 summarize_ticks;
+
+    Uint64 last_frame_ticks;
+
+    //seconds from lines arriving on STDIN to being spawned
+    double ingest_latency;
+    double ingest_latency_max;
+    double ingest_latency_total;
+    long   ingest_latency_count;
+
+    void publishMetrics();
+    void recordIngestLatency(Uint64 received);
 
     std::string filterURLHostname(const std::string& hostname);
 
     std::string dateAtPosition(float percent);
     void seekTo(float percent);
 
+    bool restoreKeyframe(time_t time);
+    void rewind(int seconds);
+    time_t ballLifetime() const;
+
+    void seekLog(float percent);
+    float logPercent();
+    bool entryAt(float percent, LogEntry& le);
+    float findPosition(time_t timestamp, float high, bool after = false);
+    void findTimeRange();
+    void warmUp(float percent);
+    void holdStrings(const LogEntry& le, time_t expires);
+    void releaseStrings(bool all = false);
+
     void readLog(int buffer_rows = 0);
+    bool nextLine(std::string& line);
+    bool detectFormat();
 
     RequestBall* findNearest(Paddle* paddle, const std::string& paddle_token);
     void updateGroups(float dt);
@@ -131,6 +233,8 @@ class Logstalgia : public SDLApp {
     Summarizer* getGroupSummarizer(LogEntry* le);
 
     void addStrings(LogEntry* le);
+    void removeStrings(LogEntry* le);
+    void removeStrings(const std::string& hostname, const std::string& path);
 
     void addBall(LogEntry* le,  float start_offset);
     void removeBall(RequestBall* ball);
@@ -139,6 +243,8 @@ class Logstalgia : public SDLApp {
 
     BaseLog* getLog();
 
+    const std::string& getPaddleToken(LogEntry* le);
+
     void reset();
 
     void reinit();
@@ -161,7 +267,11 @@ public:
 
     void addGroup(const std::string& groupstr);
 
-    void setFrameExporter(FrameExporter* exporter);
+    void setFrameExporter(AsyncFrameExporter* exporter);
+
+    void runHeadless();
+    void runBenchmark();
+    void compileLog(const std::string& output);
 
     void setBackground(vec3 background);
 
@@ -17,6 +17,8 @@
 
 #include "logstalgia.h"
 #include "settings.h"
+#include "headless.h"
+#include "segments.h"
 
 #ifdef _WIN32
 std::string win32LogSelector() {
@@ -119,7 +121,7 @@ int main(int argc, char *argv[]) {
     }
 
 #ifdef _WIN32
-    if(settings.path.empty()) {
+    if(settings.path.empty() && settings.listen_endpoint.empty()) {
 
         //open file dialog
         settings.path = win32LogSelector();
@@ -130,38 +132,171 @@ int main(int argc, char *argv[]) {
     }
 #endif
 
-    if(settings.path.empty()) SDLAppQuit("no file supplied");
+    if(settings.path.empty() && settings.listen_endpoint.empty()) SDLAppQuit("no file supplied");
 
-    //enable vsync
-    display.enableVsync(settings.vsync);
+    //parse the log once into a compiled log that replays without parsing
+    if(!settings.compile_log.empty()) {
 
-    // this causes corruption on some video drivers
-    if(settings.multisample) display.multiSample(4);
+        if(settings.path == "-" || !settings.listen_endpoint.empty() || settings.follow) {
+            SDLAppQuit("--compile-log requires a log file");
+        }
+
+        display.width  = settings.display_width;
+        display.height = settings.display_height;
+
+        //hostnames are masked when the compiled log is replayed
+        settings.mask_hostnames = false;
+
+        settings.no_display = true;
+
+        Logstalgia* ls = 0;
+
+        try {
+            ls = new Logstalgia(settings.path);
+
+            ls->compileLog(settings.compile_log);
+
+        } catch(ResourceException& exception) {
+
+            char errormsg[1024];
+            snprintf(errormsg, 1024, "failed to load resource '%s'", exception.what());
+
+            SDLAppQuit(errormsg);
+
+        } catch(SDLAppException& exception) {
+
+            SDLAppQuit(exception.what());
+        }
+
+        if(ls!=0) delete ls;
+
+        return 0;
+    }
+
+    //render the period as segments in separate processes
+    if(settings.render_segments > 1) {
+
+        try {
+
+            SegmentRenderer renderer(argc, argv);
+
+            return renderer.render(settings.render_segments);
 
-    if(settings.resizable && settings.output_ppm_filename.empty()) {
-        display.enableResize(true);
+        } catch(SDLAppException& exception) {
+
+            SDLAppQuit(exception.what());
+        }
     }
 
-    display.init("Logstalgia", settings.display_width, settings.display_height, settings.fullscreen);
+    //simulate without a display or any drawing
+    if(settings.benchmark) {
+
+        if(settings.path == "-" || !settings.listen_endpoint.empty()) {
+            SDLAppQuit("--benchmark requires a log file");
+        }
+
+        display.width  = settings.display_width;
+        display.height = settings.display_height;
+
+        settings.no_display = true;
+
+        Logstalgia* ls = 0;
+
+        try {
+            ls = new Logstalgia(settings.path);
+
+            for(const std::string& group : settings.groups) {
+                ls->addGroup(group);
+            }
+
+            ls->runBenchmark();
+
+        } catch(ResourceException& exception) {
+
+            char errormsg[1024];
+            snprintf(errormsg, 1024, "failed to load resource '%s'", exception.what());
+
+            SDLAppQuit(errormsg);
+
+        } catch(SDLAppException& exception) {
 
-    // Don't minimize when alt-tabbing so you can fullscreen logstalgia on a second monitor
+            SDLAppQuit(exception.what());
+        }
+
+        if(ls!=0) delete ls;
+
+        return 0;
+    }
+
+    if(settings.headless) {
+
+        if(settings.output_ppm_filename.empty()) {
+            SDLAppQuit("--headless requires --output-ppm-stream");
+        }
+
+        try {
+
+            headless.init(settings.display_width, settings.display_height, settings.multisample ? 4 : 0);
+
+        } catch(HeadlessDisplayException& exception) {
+
+            char errormsg[1024];
+            snprintf(errormsg, 1024, "headless: %s", exception.what());
+
+            SDLAppQuit(errormsg);
+        }
+
+    } else {
+
+        //enable vsync
+        display.enableVsync(settings.vsync);
+
+        // this causes corruption on some video drivers
+        if(settings.multisample) display.multiSample(4);
+
+        if(settings.resizable && settings.output_ppm_filename.empty()) {
+            display.enableResize(true);
+        }
+
+        display.init("Logstalgia", settings.display_width, settings.display_height, settings.fullscreen);
+
+        // Don't minimize when alt-tabbing so you can fullscreen logstalgia on a second monitor
 #if SDL_VERSION_ATLEAST(2,0,0)
-     SDL_SetHint(SDL_HINT_VIDEO_MINIMIZE_ON_FOCUS_LOSS, "0");
+        SDL_SetHint(SDL_HINT_VIDEO_MINIMIZE_ON_FOCUS_LOSS, "0");
 #endif
+    }
      
     //disable OpenGL 2.0 functions if not supported
     if(!GLEW_VERSION_2_0) settings.ffp = true;
     
+    //before the exporter starts its writer thread, so the thread is named
+    if(!settings.trace_file.empty()) {
+        tracer.open(settings.trace_file);
+    }
+
     //init frame exporter
-    FrameExporter* exporter = 0;
+    AsyncFrameExporter* exporter = 0;
 
     if(!settings.output_ppm_filename.empty()) {
 
         try {
 
-            exporter = new PPMExporter(settings.output_ppm_filename);
+            switch(settings.output_format) {
+                case OUTPUT_FORMAT_RGB24:
+                    exporter = new RawVideoExporter(settings.output_ppm_filename, 3);
+                    break;
+                case OUTPUT_FORMAT_RGBA:
+                    exporter = new RawVideoExporter(settings.output_ppm_filename, 4);
+                    break;
+                case OUTPUT_FORMAT_Y4M:
+                    exporter = new Y4MExporter(settings.output_ppm_filename, settings.output_framerate);
+                    break;
+                default:
+                    exporter = new PPMStreamExporter(settings.output_ppm_filename);
+                    break;
+            }
 
-        } catch(PPMExporterException& exception) {
+        } catch(ExporterException& exception) {
 
             char errormsg[1024];
             snprintf(errormsg, 1024, "could not write to '%s'", exception.what());
@@ -170,7 +305,21 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if(settings.multisample) glEnable(GL_MULTISAMPLE_ARB);
+    if(settings.multisample && (!settings.headless || headless.isMultisampled())) glEnable(GL_MULTISAMPLE_ARB);
+
+    MetricsServer metrics_server;
+
+    if(!settings.metrics_endpoint.empty()) {
+
+        try {
+
+            metrics_server.start(settings.metrics_endpoint);
+
+        } catch(MetricsException& exception) {
+
+            SDLAppQuit(exception.what());
+        }
+    }
 
     Logstalgia* ls = 0;
 
@@ -187,7 +336,11 @@ int main(int argc, char *argv[]) {
 
         ls->setBackground(settings.background_colour);
 
-        ls->run();
+        if(settings.headless) {
+            ls->runHeadless();
+        } else {
+            ls->run();
+        }
 
     } catch(ResourceException& exception) {
 
@@ -210,7 +363,15 @@ int main(int argc, char *argv[]) {
 
     if(exporter!=0) delete exporter;
 
-    display.quit();
+    tracer.close();
+
+    metrics_server.stop();
+
+    if(settings.headless) {
+        headless.quit();
+    } else {
+        display.quit();
+    }
 
     return 0;
 }
@@ -0,0 +1,395 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metrics.h"
+
+#include "core/logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+
+// don't raise SIGPIPE if a client disconnects early
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+#endif
+
+LogstalgiaMetrics metrics;
+
+// upper bounds of the frame time histogram buckets (seconds)
+const double metrics_frame_bounds[METRICS_FRAME_BUCKETS] = {
+    0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25, 1.0
+};
+
+// LogstalgiaMetrics
+
+LogstalgiaMetrics::LogstalgiaMetrics() {
+    fps               = 0.0;
+    queue_depth       = 0;
+    balls             = 0;
+    paddles           = 0;
+    lines_read        = 0;
+    entries_spawned   = 0;
+    entries_sampled   = 0;
+    sampling_denominator = 1;
+    summarize_seconds = 0.0;
+
+    ingest_latency_seconds = 0.0;
+    ingest_latency_count   = 0;
+    ingest_latency_max     = 0.0;
+
+    for(int i=0; i<PARSE_STAGES; i++) {
+        parse_errors[i] = 0;
+    }
+
+    for(int i=0; i<METRICS_FRAME_BUCKETS; i++) {
+        frame_buckets[i] = 0;
+    }
+
+    frame_count   = 0;
+    frame_seconds = 0.0;
+}
+
+// called from the main thread only
+void LogstalgiaMetrics::recordFrame(double seconds) {
+
+    for(int i=0; i<METRICS_FRAME_BUCKETS; i++) {
+        if(seconds <= metrics_frame_bounds[i]) {
+            frame_buckets[i].store(frame_buckets[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    frame_seconds.store(frame_seconds.load(std::memory_order_relaxed) + seconds, std::memory_order_relaxed);
+    frame_count.store(frame_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::string LogstalgiaMetrics::format() const {
+
+    std::string output;
+    char line[256];
+
+#define METRIC(name, type, help, fmt, value) \
+    snprintf(line, sizeof(line), "# HELP " name " " help "\n# TYPE " name " " type "\n" name " " fmt "\n", value); \
+    output += line;
+
+    METRIC("logstalgia_fps", "gauge", "Frames per second.", "%.2f", fps.load());
+    METRIC("logstalgia_queued_entries", "gauge", "Log entries read but not yet spawned.", "%ld", queue_depth.load());
+    METRIC("logstalgia_balls", "gauge", "Request balls on screen.", "%ld", balls.load());
+    METRIC("logstalgia_paddles", "gauge", "Paddles on screen.", "%ld", paddles.load());
+    METRIC("logstalgia_lines_read_total", "counter", "Lines read from the log.", "%ld", lines_read.load());
+    METRIC("logstalgia_entries_spawned_total", "counter", "Log entries spawned as requests.", "%ld", entries_spawned.load());
+    METRIC("logstalgia_entries_sampled_total", "counter", "Log entries not shown because their host was not sampled.", "%ld", entries_sampled.load());
+    METRIC("logstalgia_sampling_ratio", "gauge", "Fraction of hosts shown.", "%g", 1.0 / sampling_denominator.load());
+    METRIC("logstalgia_summarize_seconds_total", "counter", "Time spent summarizing hosts and URLs.", "%.6f", summarize_seconds.load());
+    METRIC("logstalgia_ingest_latency_max_seconds", "gauge", "Longest time from a line arriving on STDIN to being spawned.", "%.6f", ingest_latency_max.load());
+
+#undef METRIC
+
+    output += "# HELP logstalgia_parse_errors_total Lines that could not be parsed, by the stage they were rejected at.\n";
+    output += "# TYPE logstalgia_parse_errors_total counter\n";
+
+    for(int i=0; i<PARSE_STAGES; i++) {
+        snprintf(line, sizeof(line), "logstalgia_parse_errors_total{stage=\"%s\"} %ld\n", ParseErrors::stageName(i), parse_errors[i].load());
+        output += line;
+    }
+
+    output += "# HELP logstalgia_frame_seconds Time between frames.\n";
+    output += "# TYPE logstalgia_frame_seconds histogram\n";
+
+    for(int i=0; i<METRICS_FRAME_BUCKETS; i++) {
+        snprintf(line, sizeof(line), "logstalgia_frame_seconds_bucket{le=\"%g\"} %ld\n", metrics_frame_bounds[i], frame_buckets[i].load());
+        output += line;
+    }
+
+    long count = frame_count.load();
+
+    snprintf(line, sizeof(line), "logstalgia_frame_seconds_bucket{le=\"+Inf\"} %ld\n", count);
+    output += line;
+    snprintf(line, sizeof(line), "logstalgia_frame_seconds_sum %.6f\n", frame_seconds.load());
+    output += line;
+    snprintf(line, sizeof(line), "logstalgia_frame_seconds_count %ld\n", count);
+    output += line;
+
+    output += "# HELP logstalgia_ingest_latency_seconds Time from lines arriving on STDIN to being spawned.\n";
+    output += "# TYPE logstalgia_ingest_latency_seconds summary\n";
+
+    snprintf(line, sizeof(line), "logstalgia_ingest_latency_seconds_sum %.6f\n", ingest_latency_seconds.load());
+    output += line;
+    snprintf(line, sizeof(line), "logstalgia_ingest_latency_seconds_count %ld\n", ingest_latency_count.load());
+    output += line;
+
+#ifdef __linux__
+    // current resident set size
+    FILE* statm = fopen("/proc/self/statm", "r");
+
+    if(statm != 0) {
+        long pages = 0, resident = 0;
+
+        if(fscanf(statm, "%ld %ld", &pages, &resident) == 2) {
+            snprintf(line, sizeof(line),
+                     "# HELP process_resident_memory_bytes Resident memory size in bytes.\n"
+                     "# TYPE process_resident_memory_bytes gauge\n"
+                     "process_resident_memory_bytes %ld\n", resident * sysconf(_SC_PAGESIZE));
+            output += line;
+        }
+
+        fclose(statm);
+    }
+#endif
+
+#ifndef _WIN32
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        long peak_bytes = usage.ru_maxrss;
+#else
+        long peak_bytes = usage.ru_maxrss * 1024L;
+#endif
+        snprintf(line, sizeof(line),
+                 "# HELP logstalgia_peak_resident_memory_bytes Peak resident memory size in bytes.\n"
+                 "# TYPE logstalgia_peak_resident_memory_bytes gauge\n"
+                 "logstalgia_peak_resident_memory_bytes %ld\n", peak_bytes);
+        output += line;
+    }
+#endif
+
+    return output;
+}
+
+// MetricsServer
+
+int metrics_server_thread(void* server) {
+    ((MetricsServer*) server)->serve();
+    return 0;
+}
+
+MetricsServer::MetricsServer() {
+    thread    = 0;
+    listen_fd = -1;
+    stopping  = false;
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start(const std::string& endpoint) {
+#ifdef _WIN32
+    throw MetricsException("metrics endpoint is not supported on this platform");
+#else
+
+    bool is_port = !endpoint.empty() && endpoint.find_first_not_of("0123456789") == std::string::npos;
+
+    if(is_port) {
+
+        int port = atoi(endpoint.c_str());
+
+        if(port < 1 || port > 65535) {
+            throw MetricsException("invalid metrics port " + endpoint);
+        }
+
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+        if(listen_fd < 0) throw MetricsException("could not create metrics socket");
+
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family      = AF_INET;
+        address.sin_port        = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if(bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            throw MetricsException("could not bind metrics port " + endpoint);
+        }
+
+    } else {
+
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if(endpoint.size() >= sizeof(address.sun_path)) {
+            throw MetricsException("metrics socket path too long");
+        }
+
+        strncpy(address.sun_path, endpoint.c_str(), sizeof(address.sun_path) - 1);
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if(listen_fd < 0) throw MetricsException("could not create metrics socket");
+
+        // replace a stale socket left by a previous run, but nothing else
+        struct stat existing;
+
+        if(lstat(endpoint.c_str(), &existing) == 0) {
+            if(!S_ISSOCK(existing.st_mode)) {
+                close(listen_fd);
+                listen_fd = -1;
+                throw MetricsException("metrics endpoint " + endpoint + " exists and is not a socket");
+            }
+
+            unlink(endpoint.c_str());
+        }
+
+        if(bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+            close(listen_fd);
+            listen_fd = -1;
+            throw MetricsException("could not bind metrics socket " + endpoint);
+        }
+
+        socket_path = endpoint;
+    }
+
+    if(listen(listen_fd, 8) != 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        throw MetricsException("could not listen on metrics endpoint " + endpoint);
+    }
+
+    stopping = false;
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    thread = SDL_CreateThread(metrics_server_thread, "metrics_server", this);
+#else
+    thread = SDL_CreateThread(metrics_server_thread, this);
+#endif
+
+    debugLog("serving metrics on %s", endpoint.c_str());
+#endif
+}
+
+void MetricsServer::stop() {
+#ifndef _WIN32
+    if(thread != 0) {
+        stopping = true;
+        SDL_WaitThread(thread, 0);
+        thread = 0;
+    }
+
+    if(listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+
+    if(!socket_path.empty()) {
+        unlink(socket_path.c_str());
+        socket_path.clear();
+    }
+#endif
+}
+
+void MetricsServer::serve() {
+#ifndef _WIN32
+    while(!stopping) {
+
+        // wake up periodically to check for shutdown
+        struct pollfd pfd;
+        pfd.fd      = listen_fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, 250);
+
+        if(ready <= 0) continue;
+
+        int fd = accept(listen_fd, 0, 0);
+
+        if(fd < 0) continue;
+
+#ifdef SO_NOSIGPIPE
+        int nosigpipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+
+        respond(fd);
+
+        close(fd);
+    }
+#endif
+}
+
+void MetricsServer::respond(int fd) {
+#ifndef _WIN32
+
+    // read the request headers (the request itself is not inspected,
+    // every path returns the metrics)
+    char request[1024];
+    size_t received = 0;
+
+    while(received < sizeof(request) - 1) {
+
+        struct pollfd pfd;
+        pfd.fd      = fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+
+        if(poll(&pfd, 1, 1000) <= 0) break;
+
+        ssize_t n = recv(fd, request + received, sizeof(request) - 1 - received, 0);
+
+        if(n <= 0) break;
+
+        received += n;
+        request[received] = '\0';
+
+        if(strstr(request, "\r\n\r\n") != 0 || strstr(request, "\n\n") != 0) break;
+    }
+
+    std::string body = metrics.format();
+
+    char header[256];
+    snprintf(header, sizeof(header),
+             "HTTP/1.0 200 OK\r\n"
+             "Content-Type: text/plain; version=0.0.4\r\n"
+             "Content-Length: %lu\r\n"
+             "Connection: close\r\n\r\n", (unsigned long) body.size());
+
+    std::string response = std::string(header) + body;
+
+    size_t sent = 0;
+
+    while(sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, METRICS_SEND_FLAGS);
+
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) break;
+
+        sent += n;
+    }
+#endif
+}
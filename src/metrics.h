@@ -0,0 +1,103 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_METRICS_H
+#define LOGSTALGIA_METRICS_H
+
+#include "core/display.h"
+
+#include "logentry.h"
+
+#include <string>
+#include <atomic>
+#include <exception>
+
+#define METRICS_FRAME_BUCKETS 10
+
+// Counters published by the main thread each frame and read by the metrics
+// server thread. Each value has a single writer so plain atomic loads and
+// stores are sufficient and neither side ever blocks.
+
+class LogstalgiaMetrics {
+public:
+    std::atomic<double> fps;
+
+    std::atomic<long> queue_depth;
+    std::atomic<long> balls;
+    std::atomic<long> paddles;
+
+    std::atomic<long> lines_read;
+    std::atomic<long> entries_spawned;
+    std::atomic<long> entries_sampled;
+    std::atomic<long> sampling_denominator;
+    std::atomic<long> parse_errors[PARSE_STAGES];
+
+    std::atomic<double> summarize_seconds;
+
+    // time from lines arriving on STDIN to being spawned
+    std::atomic<double> ingest_latency_seconds;
+    std::atomic<long>   ingest_latency_count;
+    std::atomic<double> ingest_latency_max;
+
+    // frame time histogram (cumulative counts per upper bound)
+    std::atomic<long>   frame_buckets[METRICS_FRAME_BUCKETS];
+    std::atomic<long>   frame_count;
+    std::atomic<double> frame_seconds;
+
+    LogstalgiaMetrics();
+
+    void recordFrame(double seconds);
+
+    std::string format() const;
+};
+
+extern LogstalgiaMetrics metrics;
+
+class MetricsException : public std::exception {
+protected:
+    std::string message;
+public:
+    MetricsException(const std::string& message) : message(message) {}
+    virtual ~MetricsException() throw () {};
+
+    virtual const char* what() const throw() { return message.c_str(); }
+};
+
+// Serves the metrics in the Prometheus text format over HTTP from a
+// background thread. The endpoint is a port number (bound to localhost)
+// or the path of a unix socket.
+
+class MetricsServer {
+    SDL_Thread* thread;
+
+    int listen_fd;
+    std::string socket_path;
+
+    std::atomic<bool> stopping;
+
+    void respond(int fd);
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    void start(const std::string& endpoint);
+    void stop();
+
+    void serve();
+};
+
+#endif
@@ -33,11 +33,18 @@ NCSALog::NCSALog() {
 //parse NCSA format access.log entry into components
 bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
 
+    //reject lines without a [date] followed by a "request" before running any regex
+    size_t date_start = line.find('[');
+
+    if(date_start == std::string::npos || line.find('"', date_start) == std::string::npos) {
+        return reject(PARSE_STAGE_PREFILTER);
+    }
+
     std::vector<std::string> matches;
     ls_ncsa_entry_start.match(line, &matches);
 
     if(matches.size()!=5) {
-        return 0;
+        return reject(PARSE_STAGE_START);
     }
 
     //get details
@@ -57,7 +64,7 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     ls_ncsa_entry_date.match(datestr, &matches);
 
     if(matches.size()!=8) {
-        return 0;
+        return reject(PARSE_STAGE_DATE);
     }
 
     day    = atoi(matches[0].c_str());
@@ -80,7 +87,7 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     }
 
     //could not parse month (range 0-11 as used by mktime)
-    if(month<0 || month>11) return 0;
+    if(month<0 || month>11) return reject(PARSE_STAGE_DATE);
 
     //convert zone to utc offset
     int tz_hour = atoi(matches[7].substr(0,2).c_str());
@@ -109,7 +116,7 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     ls_ncsa_entry_request.match(request_str, &matches);
 
     if(matches.size() < 5) {
-        return 0;
+        return reject(PARSE_STAGE_REQUEST);
     }
 
 //    entry.method    = matches[0];
@@ -158,6 +165,8 @@ bool NCSALog::parseLine(std::string& line, LogEntry& entry) {
     entry.setSuccess();
     entry.setResponseColour();
 
-    return entry.validate();
+    if(!entry.validate()) return reject(PARSE_STAGE_VALIDATE);
+
+    return true;
 }
 
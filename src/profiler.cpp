@@ -0,0 +1,198 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "profiler.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <string.h>
+
+FrameProfiler profiler;
+
+// ProfileZone
+
+ProfileZone::ProfileZone(const std::string& name, ProfileZone* parent)
+    : name(name), parent(parent) {
+
+    history.resize(PROFILER_HISTORY, 0);
+    history_index = 0;
+    history_count = 0;
+
+    frame_ticks = 0;
+    frame_calls = 0;
+}
+
+ProfileZone::~ProfileZone() {
+    for(ProfileZone* child : children) {
+        delete child;
+    }
+}
+
+ProfileZone* ProfileZone::getChild(const char* name) {
+
+    for(ProfileZone* child : children) {
+        if(strcmp(child->name.c_str(), name) == 0) return child;
+    }
+
+    ProfileZone* child = new ProfileZone(name, this);
+    children.push_back(child);
+
+    return child;
+}
+
+void ProfileZone::endFrame() {
+
+    //only frames the zone was entered in count towards its statistics
+    if(frame_calls > 0) {
+        history[history_index] = frame_ticks;
+        history_index = (history_index + 1) % PROFILER_HISTORY;
+        history_count = std::min(history_count + 1, PROFILER_HISTORY);
+    }
+
+    frame_ticks = 0;
+    frame_calls = 0;
+
+    for(ProfileZone* child : children) {
+        child->endFrame();
+    }
+}
+
+void ProfileZone::clear() {
+    history_index = 0;
+    history_count = 0;
+    frame_ticks   = 0;
+    frame_calls   = 0;
+
+    for(ProfileZone* child : children) {
+        child->clear();
+    }
+}
+
+bool ProfileZone::getStats(Uint64& min, Uint64& avg, Uint64& p99) const {
+
+    if(history_count == 0) return false;
+
+    std::vector<Uint64> samples(history.begin(), history.begin() + history_count);
+
+    Uint64 total = 0;
+
+    for(Uint64 sample : samples) {
+        total += sample;
+    }
+
+    avg = total / history_count;
+    min = *std::min_element(samples.begin(), samples.end());
+
+    size_t rank = (size_t) std::max(0, (history_count * 99 + 99) / 100 - 1);
+
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    p99 = samples[rank];
+
+    return true;
+}
+
+// FrameProfiler
+
+FrameProfiler::FrameProfiler() : root("frame", 0) {
+    enabled           = false;
+    enable_next_frame = false;
+    in_frame          = false;
+    current           = &root;
+    frame_start       = 0;
+    ms_per_tick       = 0.0;
+}
+
+void FrameProfiler::setEnabled(bool enabled) {
+    enable_next_frame = enabled;
+}
+
+void FrameProfiler::beginFrame() {
+
+    if(enabled != enable_next_frame) {
+        enabled = enable_next_frame;
+
+        //start with fresh statistics each time the profiler is turned on
+        if(enabled) root.clear();
+    }
+
+    if(!enabled) return;
+
+    if(ms_per_tick == 0.0) {
+        ms_per_tick = 1000.0 / (double) profiler_ticks_per_second();
+    }
+
+    current     = &root;
+    in_frame    = true;
+    frame_start = profiler_ticks();
+}
+
+void FrameProfiler::endFrame() {
+    if(!in_frame) return;
+
+    root.frame_ticks = profiler_ticks() - frame_start;
+    root.frame_calls = 1;
+
+    tracer.record(root.name.c_str(), frame_start, root.frame_ticks);
+
+    root.endFrame();
+
+    current  = &root;
+    in_frame = false;
+}
+
+ProfileZone* FrameProfiler::enter(const char* name) {
+    current = current->getChild(name);
+    return current;
+}
+
+void FrameProfiler::leave(ProfileZone* zone, Uint64 start_ticks, Uint64 end_ticks) {
+    zone->frame_ticks += end_ticks - start_ticks;
+    zone->frame_calls++;
+
+    tracer.record(zone->name.c_str(), start_ticks, end_ticks - start_ticks);
+
+    if(zone->parent != 0) current = zone->parent;
+}
+
+int FrameProfiler::drawZone(FXFont& font, ProfileZone* zone, int depth, int x, int y) {
+
+    Uint64 min, avg, p99;
+
+    if(zone->getStats(min, avg, p99)) {
+
+        std::string label = std::string(depth*2, ' ') + zone->name;
+
+        font.print(x, y, "%-28.28s %8.3f %8.3f %8.3f", label.c_str(),
+                   min * ms_per_tick, avg * ms_per_tick, p99 * ms_per_tick);
+
+        y += 17;
+    }
+
+    for(ProfileZone* child : zone->children) {
+        y = drawZone(font, child, depth+1, x, y);
+    }
+
+    return y;
+}
+
+void FrameProfiler::draw(FXFont& font, int x, int y) {
+    if(!enabled) return;
+
+    font.print(x, y, "%-28s %8s %8s %8s", "Profile (ms)", "min", "avg", "p99");
+
+    drawZone(font, &root, 0, x, y + 17);
+}
@@ -0,0 +1,136 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_PROFILER_H
+#define LOGSTALGIA_PROFILER_H
+
+#include "core/display.h"
+#include "core/fxfont.h"
+
+#include <string>
+#include <vector>
+
+#if !SDL_VERSION_ATLEAST(2,0,0) && !defined(_WIN32)
+#include <time.h>
+#endif
+
+// number of frames the rolling zone statistics are calculated over
+#define PROFILER_HISTORY 120
+
+// high resolution timer (nanoseconds on most platforms)
+
+inline Uint64 profiler_ticks() {
+#if SDL_VERSION_ATLEAST(2,0,0)
+    return SDL_GetPerformanceCounter();
+#elif !defined(_WIN32)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return (Uint64) SDL_GetTicks() * 1000000;
+#endif
+}
+
+inline Uint64 profiler_ticks_per_second() {
+#if SDL_VERSION_ATLEAST(2,0,0)
+    return SDL_GetPerformanceFrequency();
+#else
+    return 1000000000;
+#endif
+}
+
+// Frame profiler.
+//
+// Zones are timed with a ProfileScope and form a tree following the nesting
+// of the scopes at runtime. Each zone accumulates its time over a frame and
+// keeps a rolling history of per frame times for min/avg/p99 statistics.
+//
+// Zones are also recorded as trace events while a trace is being recorded.
+//
+// When disabled a ProfileScope only tests a flag.
+
+class ProfileZone {
+    std::vector<Uint64> history;
+    int history_index;
+    int history_count;
+public:
+    std::string name;
+    ProfileZone* parent;
+    std::vector<ProfileZone*> children;
+
+    Uint64 frame_ticks;
+    int    frame_calls;
+
+    ProfileZone(const std::string& name, ProfileZone* parent);
+    ~ProfileZone();
+
+    ProfileZone* getChild(const char* name);
+
+    void endFrame();
+    void clear();
+
+    bool getStats(Uint64& min, Uint64& avg, Uint64& p99) const;
+};
+
+class FrameProfiler {
+    bool enabled;
+    bool enable_next_frame;
+    bool in_frame;
+
+    ProfileZone root;
+    ProfileZone* current;
+
+    Uint64 frame_start;
+    double ms_per_tick;
+
+    int drawZone(FXFont& font, ProfileZone* zone, int depth, int x, int y);
+public:
+    FrameProfiler();
+
+    bool isEnabled() const { return enabled; };
+
+    // takes effect at the start of the next frame
+    void setEnabled(bool enabled);
+
+    void beginFrame();
+    void endFrame();
+
+    ProfileZone* enter(const char* name);
+    void leave(ProfileZone* zone, Uint64 start_ticks, Uint64 end_ticks);
+
+    void draw(FXFont& font, int x, int y);
+};
+
+extern FrameProfiler profiler;
+
+class ProfileScope {
+    ProfileZone* zone;
+    Uint64 start_ticks;
+public:
+    ProfileScope(const char* name) : zone(0) {
+        if(profiler.isEnabled()) {
+            zone = profiler.enter(name);
+            start_ticks = profiler_ticks();
+        }
+    }
+
+    ~ProfileScope() {
+        if(zone != 0) profiler.leave(zone, start_ticks, profiler_ticks());
+    }
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "reorderbuffer.h"
+
+#include <algorithm>
+
+// orders the heap with the oldest entry at the top
+static bool reorder_entry_later(const ReorderEntry& a, const ReorderEntry& b) {
+    if(a.entry.timestamp != b.entry.timestamp) return a.entry.timestamp > b.entry.timestamp;
+    return a.sequence > b.sequence;
+}
+
+ReorderBuffer::ReorderBuffer() {
+    sequence = 0;
+    newest   = 0;
+    window   = 0;
+}
+
+void ReorderBuffer::push(const LogEntry& entry) {
+
+    heap.push_back(ReorderEntry());
+
+    ReorderEntry& item = heap.back();
+    item.entry    = entry;
+    item.sequence = sequence++;
+
+    std::push_heap(heap.begin(), heap.end(), reorder_entry_later);
+
+    if(entry.timestamp > newest) newest = entry.timestamp;
+}
+
+void ReorderBuffer::releaseUntil(EntryQueue& queue, time_t time) {
+
+    while(!heap.empty() && heap.front().entry.timestamp <= time) {
+
+        std::pop_heap(heap.begin(), heap.end(), reorder_entry_later);
+
+        queue.push(heap.back().entry);
+
+        heap.pop_back();
+    }
+}
+
+void ReorderBuffer::release(EntryQueue& queue, time_t now) {
+
+    time_t time = std::max(newest, now) - window;
+
+    releaseUntil(queue, time);
+}
+
+void ReorderBuffer::flush(EntryQueue& queue) {
+
+    while(!heap.empty()) {
+
+        std::pop_heap(heap.begin(), heap.end(), reorder_entry_later);
+
+        queue.push(heap.back().entry);
+
+        heap.pop_back();
+    }
+}
+
+void ReorderBuffer::clear() {
+    heap.clear();
+    newest = 0;
+}
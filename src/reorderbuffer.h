@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_REORDERBUFFER_H
+#define LOGSTALGIA_REORDERBUFFER_H
+
+#include "logentry.h"
+#include "entryqueue.h"
+
+#include <vector>
+#include <time.h>
+
+struct ReorderEntry {
+    LogEntry entry;
+    long sequence;
+};
+
+// Holds parsed entries in a min-heap for a window of seconds so entries
+// written slightly out of order (eg by several workers behind a load
+// balancer) are queued in timestamp order. An entry is released once an
+// entry more than the window newer has been read, or once the clock has
+// passed it by the window for live input. Entries with the same timestamp
+// keep the order they were read in.
+
+class ReorderBuffer {
+    std::vector<ReorderEntry> heap;
+    long sequence;
+    time_t newest;
+    int window;
+
+    void releaseUntil(EntryQueue& queue, time_t time);
+public:
+    ReorderBuffer();
+
+    void setWindow(int seconds) { window = seconds; };
+    int getWindow() const { return window; };
+
+    bool empty() const { return heap.empty(); };
+    size_t size() const { return heap.size(); };
+
+    void push(const LogEntry& entry);
+
+    // moves entries out of the window into the queue. now is the current
+    // time for live input, or 0
+    void release(EntryQueue& queue, time_t now = 0);
+
+    // moves all entries into the queue
+    void flush(EntryQueue& queue);
+
+    void clear();
+};
+
+#endif
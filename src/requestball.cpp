@@ -24,9 +24,10 @@ RequestBall::RequestBall(LogEntry* le, const vec3& colour, const vec2& pos, cons
 
     dir = glm::normalize(dest - pos);
 
-    int bytes = le->response_size;
-    size = log((float)bytes) + 1.0f;
-    if(size<5.0f) size = 5.0f;
+    total_bytes = le->response_size;
+    total_time  = le->request_time;
+
+    updateSize();
 
     has_bounced = false;
     no_bounce   = !le->successful;
@@ -36,13 +37,51 @@ RequestBall::RequestBall(LogEntry* le, const vec3& colour, const vec2& pos, cons
 
     points.push_back(pos);
     addPoint(dest);
+}
+
+RequestBall::~RequestBall() {
+    delete le;
+
+    for(LogEntry* merged : merged_entries) {
+        delete merged;
+    }
+}
+
+void RequestBall::updateSize() {
+
+    if(settings.ball_size == BALL_SIZE_TIME) {
+        //scale with the average request time in milliseconds
+        float msec = 1000.0f * total_time / (float) getCount();
+        size = 1.5f * log(msec + 1.0f) + 3.0f;
+    } else {
+        size = log((float)total_bytes) + 1.0f;
+    }
+
+    if(size<5.0f) size = 5.0f;
+
+    //aggregate balls grow with the number of requests they represent
+    if(!merged_entries.empty()) {
+        size += 2.0f * log2((float) getCount());
+    }
 
     float halfsize = size * 0.5f;
     offset = vec2(halfsize, halfsize);
 }
 
-RequestBall::~RequestBall() {
-    delete le;
+void RequestBall::merge(LogEntry* entry) {
+    merged_entries.push_back(entry);
+    total_bytes += entry->response_size;
+    total_time  += entry->request_time;
+
+    updateSize();
+}
+
+int RequestBall::getCount() const {
+    return merged_entries.size() + 1;
+}
+
+const std::vector<LogEntry*>& RequestBall::getMergedEntries() const {
+    return merged_entries;
 }
 
 void RequestBall::addPoint(const vec2& p) {
@@ -164,6 +203,20 @@ bool RequestBall::mouseOver(TextArea& textarea, vec2& mouse) {
 
         content.push_back( std::string("Remote-Host:  ") + le->hostname );
 
+        if(le->upstream.size()>0) content.push_back( std::string("Upstream:     ") + le->upstream );
+
+        if(le->request_time > 0.0f) {
+            char timestr[64];
+            snprintf(timestr, 64, "Request-Time: %.3f s", le->request_time);
+            content.push_back( std::string(timestr) );
+        }
+
+        if(!merged_entries.empty()) {
+            char countstr[64];
+            snprintf(countstr, 64, "Requests:     %d (%ld bytes)", getCount(), total_bytes);
+            content.push_back( std::string(countstr) );
+        }
+
         if(le->referrer.size()>0)   content.push_back( std::string("Referrer:     ") + le->referrer );
         if(le->user_agent.size()>0) content.push_back( std::string("User-Agent:   ") + le->user_agent );
 
@@ -221,8 +274,8 @@ int RequestBall::logic(float dt) {
 
     animate(dt);
 
-    //returns 1 if just became visible (for score incrementing)
-    return (old_x<0.0f && pos.x>=0.0f);
+    //returns the number of requests if just became visible (for score incrementing)
+    return (old_x<0.0f && pos.x>=0.0f) ? getCount() : 0;
 }
 
 void RequestBall::drawGlow() const {
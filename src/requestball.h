@@ -33,6 +33,11 @@ protected:
 
     LogEntry* le;
 
+    //additional entries aggregated into this ball
+    std::vector<LogEntry*> merged_entries;
+    long total_bytes;
+    float total_time;
+
     float size;
 
     vec2 pos;
@@ -56,6 +61,8 @@ protected:
 
     void addPoint(const vec2& p);
 
+    void updateSize();
+
     void animate(float dt);
 public:
     RequestBall(LogEntry* le, const vec3& colour, const vec2& pos, const vec2& dest);
@@ -73,6 +80,10 @@ public:
     const vec3& getColour() const;
     LogEntry* getLogEntry() const;
 
+    void merge(LogEntry* le);
+    int getCount() const;
+    const std::vector<LogEntry*>& getMergedEntries() const;
+
     int logic(float dt);
 
     void drawGlow() const;
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sampler.h"
+
+#include "core/logger.h"
+
+HostSampler::HostSampler() {
+    reset();
+}
+
+void HostSampler::reset() {
+    denominator = 1;
+    frame_time  = 0.0;
+    hold        = 0;
+}
+
+void HostSampler::frame(float dt) {
+    frame_time = frame_time * 0.9 + dt * 0.1;
+}
+
+void HostSampler::update(int requests_due) {
+
+    if(hold > 0) hold--;
+
+    int previous = denominator;
+
+    //too many requests to spawn is known exactly, so act on it immediately
+    while(requests_due / denominator > SAMPLER_SPAWN_LIMIT && denominator < SAMPLER_MAX_DENOMINATOR) {
+        denominator *= 2;
+    }
+
+    if(denominator == previous && hold == 0) {
+
+        if(frame_time > SAMPLER_FRAME_TIME_HIGH && denominator < SAMPLER_MAX_DENOMINATOR) {
+            denominator *= 2;
+
+        //only show more hosts if there is room for twice as many requests
+        } else if(frame_time < SAMPLER_FRAME_TIME_LOW && denominator > 1
+                  && requests_due / (denominator / 2) <= SAMPLER_SPAWN_LIMIT / 2) {
+            denominator /= 2;
+        }
+    }
+
+    if(denominator != previous) {
+        debugLog("showing 1/%d of hosts (frame time %.1f ms, %d requests due)", denominator, frame_time * 1000.0, requests_due);
+        hold = SAMPLER_HOLD_SECONDS;
+    }
+}
+
+bool HostSampler::keep(const std::string& hostname) const {
+
+    if(denominator == 1) return true;
+
+    //FNV-1a with a final mix so the low bits depend on every character
+    unsigned int hash = 2166136261u;
+
+    for(unsigned char c : hostname) {
+        hash = (hash ^ c) * 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+
+    return (hash & (denominator - 1)) == 0;
+}
@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_SAMPLER_H
+#define LOGSTALGIA_SAMPLER_H
+
+#include <string>
+
+// smallest fraction of hosts shown (1/N)
+#define SAMPLER_MAX_DENOMINATOR 256
+
+// smoothed frame times above which fewer hosts are shown, and below which
+// more hosts are shown again
+#define SAMPLER_FRAME_TIME_HIGH (1.0 / 30.0)
+#define SAMPLER_FRAME_TIME_LOW  (1.0 / 50.0)
+
+// most requests spawned per second of the log
+#define SAMPLER_SPAWN_LIMIT 2000
+
+// seconds to wait after changing the ratio for the frame time to settle
+#define SAMPLER_HOLD_SECONDS 3
+
+// Sheds load when live input arrives faster than it can be animated by
+// only spawning balls for a fraction (1/N) of hosts. Hosts are selected by
+// a hash of their name so all the requests of a host are either shown or
+// not, and the hosts shown at 1/2N are a subset of those shown at 1/N.
+
+class HostSampler {
+    int denominator;
+    double frame_time;
+    int hold;
+public:
+    HostSampler();
+
+    void reset();
+
+    // called every frame
+    void frame(float dt);
+
+    // called once per second of the log with the number of requests due
+    void update(int requests_due);
+
+    bool keep(const std::string& hostname) const;
+
+    bool isSampling() const { return denominator > 1; };
+    int getDenominator() const { return denominator; };
+};
+
+#endif
@@ -0,0 +1,270 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "segments.h"
+#include "settings.h"
+
+#include "core/sdlapp.h"
+#include "core/conffile.h"
+
+#include <fstream>
+#include <cmath>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// options removed from the arguments of each child process (has_value if the
+// option takes an argument, replaced if the child is given its own value)
+struct SegmentOption {
+    const char* name;
+    bool has_value;
+    bool replaced;
+};
+
+const SegmentOption segment_options[] = {
+    { "-o",                  true,  true  },
+    { "--output-ppm-stream", true,  true  },
+    { "--from",              true,  true  },
+    { "--to",                true,  true  },
+    { "--start-position",    true,  false },
+    { "--stop-position",     true,  false },
+    { "--preroll",           true,  true  },
+    { "--output-frames",     true,  true  },
+    { "--render-segments",   true,  false },
+    { "--trace-file",        true,  false },
+    { "--metrics",           true,  false },
+    { "--headless",          false, true  },
+    { 0, false, false }
+};
+
+SegmentRenderer::SegmentRenderer(int argc, char* argv[]) {
+
+    executable = argv[0];
+
+    filterArgs(argc, argv);
+
+    if(!settings.load_config.empty()) checkConfig(settings.load_config);
+
+    // split output path into stem and extension (video.y4m -> video, .y4m)
+    std::string output = settings.output_ppm_filename;
+
+    size_t dot   = output.rfind('.');
+    size_t slash = output.find_last_of("/\\");
+
+    if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        output_stem = output.substr(0, dot);
+        output_ext  = output.substr(dot);
+    } else {
+        output_stem = output;
+    }
+}
+
+void SegmentRenderer::filterArgs(int argc, char* argv[]) {
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+
+        bool skip = false;
+
+        for(const SegmentOption* opt = segment_options; opt->name != 0; opt++) {
+
+            std::string name = opt->name;
+
+            if(arg == name) {
+                if(opt->has_value) i++;
+                skip = true;
+                break;
+            }
+
+            // --name=value
+            if(opt->has_value && arg.compare(0, name.size()+1, name + "=") == 0) {
+                skip = true;
+                break;
+            }
+        }
+
+        if(!skip) base_args.push_back(arg);
+    }
+}
+
+// children load the same config, and options they aren't given their own
+// value for would apply to every segment
+void SegmentRenderer::checkConfig(const std::string& config_file) {
+
+    ConfFile conf;
+
+    try {
+        conf.load(config_file);
+    } catch(ConfFileException& exception) {
+        throw SDLAppException("%s", exception.what());
+    }
+
+    ConfSectionList* sections = conf.getSections("logstalgia");
+
+    if(sections == 0) return;
+
+    for(ConfSection* section : *sections) {
+        for(const SegmentOption* opt = segment_options; opt->name != 0; opt++) {
+
+            if(opt->replaced) continue;
+
+            std::string key = std::string(opt->name).substr(2);
+
+            if(section->getEntry(key) != 0) {
+                throw SDLAppException("--render-segments can't be used with a config that sets %s", key.c_str());
+            }
+        }
+    }
+}
+
+std::string SegmentRenderer::segmentPath(int segment) const {
+    char suffix[32];
+    snprintf(suffix, 32, "-%03d", segment);
+
+    return output_stem + suffix + output_ext;
+}
+
+std::string SegmentRenderer::concatListPath() const {
+    return output_stem + "-segments.txt";
+}
+
+// ffmpeg concat demuxer list (paths are relative to the list)
+void SegmentRenderer::writeConcatList(int segments) const {
+
+    std::ofstream list(concatListPath().c_str());
+
+    if(!list.good()) {
+        throw SDLAppException("could not write to '%s'", concatListPath().c_str());
+    }
+
+    for(int i=0; i<segments; i++) {
+        std::string path = segmentPath(i);
+
+        size_t slash = path.find_last_of("/\\");
+        if(slash != std::string::npos) path = path.substr(slash+1);
+
+        list << "file '" << path << "'\n";
+    }
+}
+
+int SegmentRenderer::render(int segments) {
+
+#ifdef _WIN32
+    throw SDLAppException("--render-segments is not supported on this platform");
+#else
+    if(settings.output_ppm_filename.empty() || settings.output_ppm_filename == "-") {
+        throw SDLAppException("--render-segments requires an output file (-o)");
+    }
+
+    if(settings.path.empty() || settings.path == "-" || !settings.listen_endpoint.empty()) {
+        throw SDLAppException("--render-segments requires a log file");
+    }
+
+    if(!settings.start_time || !settings.stop_time || settings.stop_time <= settings.start_time) {
+        throw SDLAppException("--render-segments requires a --from and --to period");
+    }
+
+    time_t period = settings.stop_time - settings.start_time;
+
+    if(period < segments) {
+        throw SDLAppException("period too short to split into %d segments", segments);
+    }
+
+    // simulation seconds per recorded frame
+    double frame_seconds = settings.simulation_speed / (double) settings.output_framerate;
+
+    std::vector<pid_t> children;
+
+    for(int i=0; i<segments; i++) {
+
+        // segment boundaries on whole seconds, frame counts from cumulative
+        // boundaries so the total matches rendering the period in one go
+        time_t segment_start = settings.start_time + (period * i) / segments;
+        time_t segment_stop  = settings.start_time + (period * (i+1)) / segments;
+
+        long first_frame = lround((segment_start - settings.start_time) / frame_seconds);
+        long last_frame  = lround((segment_stop  - settings.start_time) / frame_seconds);
+
+        char from_arg[64], to_arg[64], preroll_arg[64], frames_arg[64];
+
+        snprintf(from_arg,    64, "@%lld", (long long) segment_start);
+        snprintf(to_arg,      64, "@%lld", (long long) segment_stop);
+        snprintf(preroll_arg, 64, "%.3f", settings.preroll);
+        snprintf(frames_arg,  64, "%ld", last_frame - first_frame);
+
+        std::vector<std::string> args;
+        args.push_back(executable);
+        args.insert(args.end(), base_args.begin(), base_args.end());
+
+        args.push_back("--headless");
+        args.push_back("--disable-auto-skip");
+        args.push_back("--from");          args.push_back(from_arg);
+        args.push_back("--to");            args.push_back(to_arg);
+        args.push_back("--preroll");       args.push_back(preroll_arg);
+        args.push_back("--output-frames"); args.push_back(frames_arg);
+        args.push_back("-o");              args.push_back(segmentPath(i));
+
+        printf("segment %d: %ld frames -> %s\n", i, last_frame - first_frame, segmentPath(i).c_str());
+
+        pid_t pid = fork();
+
+        if(pid < 0) {
+            throw SDLAppException("failed to start segment %d", i);
+        }
+
+        if(pid == 0) {
+            std::vector<char*> child_argv;
+
+            for(std::string& arg : args) {
+                child_argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            child_argv.push_back(0);
+
+            execvp(child_argv[0], &(child_argv[0]));
+
+            // only reached if exec failed
+            _exit(127);
+        }
+
+        children.push_back(pid);
+    }
+
+    int failed = 0;
+
+    for(size_t i=0; i<children.size(); i++) {
+        int status = 0;
+
+        if(waitpid(children[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "segment %d failed\n", (int) i);
+            failed++;
+        }
+    }
+
+    if(failed > 0) {
+        throw SDLAppException("%d of %d segments failed", failed, segments);
+    }
+
+    writeConcatList(segments);
+
+    printf("wrote %s\n", concatListPath().c_str());
+
+    return 0;
+#endif
+}
@@ -0,0 +1,52 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_SEGMENTS_H
+#define LOGSTALGIA_SEGMENTS_H
+
+#include <string>
+#include <vector>
+#include <time.h>
+
+// Renders the --from / --to period as separate headless logstalgia processes
+// (one per segment) running in parallel, then writes an ffmpeg concat list.
+//
+// Each segment starts --preroll seconds early to warm up the simulation and
+// records a fixed number of frames so the segments join end to end.
+
+class SegmentRenderer {
+
+    std::vector<std::string> base_args;
+
+    std::string executable;
+    std::string output_stem;
+    std::string output_ext;
+
+    void filterArgs(int argc, char* argv[]);
+    void checkConfig(const std::string& config_file);
+
+    std::string segmentPath(int segment) const;
+    std::string concatListPath() const;
+
+    void writeConcatList(int segments) const;
+public:
+    SegmentRenderer(int argc, char* argv[]);
+
+    int render(int segments);
+};
+
+#endif
@@ -50,15 +50,28 @@ void LogstalgiaSettings::help(bool extended_help) {
     printf("                             Group together requests where the HOST, URI\n");
     printf("                             or response CODE matches a regular expression\n\n");
 
-    printf("  --paddle-mode MODE         Paddle mode (single, pid, vhost)\n");
+    printf("  --paddle-mode MODE         Paddle mode (single, pid, vhost, upstream)\n");
     printf("  --paddle-position POSITION Paddle position as a fraction of the view width\n\n");
 
-    printf("  --sync                     Read from STDIN, ignoring entries before now\n\n");
+    printf("  --log-format FORMAT        Apache LogFormat or nginx log_format of the log\n");
+    printf("                             or 'json' for one JSON object per line\n");
+    printf("  --json-fields FIELD=KEY,.. Assign JSON keys to fields of JSON logs\n");
+    printf("  --ball-size MODE           Size balls by response size or request time\n");
+    printf("                             (bytes, time)\n\n");
+
+    printf("  --sync                     Read from STDIN, ignoring entries before now\n");
+    printf("  --follow                   Keep reading the log file as it is written to\n");
+    printf("  --listen [ADDRESS:]PORT    Receive the log from syslog over UDP and TCP\n\n");
+
+    printf("  --reorder-window SECONDS   Hold entries to put them in order when they\n");
+    printf("                             are written up to SECONDS out of order\n\n");
 
     printf("  --from, --to 'YYYY-MM-DD hh:mm:ss'  Show entries from a specific time period\n\n");
 
     printf("  --start-position POSITION  Begin at some position in the log (0.0 - 1.0)\n");
-    printf("  --stop-position  POSITION  Stop at some position\n\n");
+    printf("  --stop-position  POSITION  Stop at some position\n");
+    printf("  --warmup SECONDS           Summarize SECONDS of entries before a position\n");
+    printf("                             sought to (default: 60)\n\n");
 
     printf("  --no-bounce                No bouncing\n\n");
 
@@ -73,6 +86,9 @@ void LogstalgiaSettings::help(bool extended_help) {
 
     printf("  --font-size SIZE           Font size\n\n");
 
+    printf("  --ball-budget COUNT        Merge similar requests into aggregate balls\n");
+    printf("                             when more than COUNT balls are on screen\n\n");
+
     printf("  --glow-duration            Duration of the glow (default: 0.15)\n");
     printf("  --glow-multiplier          Adjust the amount of glow (default: 1.25)\n");
     printf("  --glow-intensity           Intensity of the glow (default: 0.5)\n\n");
@@ -81,7 +97,23 @@ void LogstalgiaSettings::help(bool extended_help) {
     printf("  --save-config CONF_FILE    Save a config file with the current options\n\n");
 
     printf("  -o, --output-ppm-stream FILE   Write frames as PPM to a file ('-' for STDOUT)\n");
-    printf("  -r, --output-framerate  FPS    Framerate of output (25,30,60)\n\n");
+    printf("  -r, --output-framerate  FPS    Framerate of output (25,30,60)\n");
+    printf("  --output-format FORMAT         Format of output (ppm, rgb24, rgba, y4m)\n");
+    printf("  --output-frames FRAMES         Stop after writing a number of frames\n");
+    printf("  --preroll SECONDS              Simulate SECONDS before --from without recording\n");
+    printf("  --render-segments N            Render --from to --to as N segments in parallel\n");
+    printf("  --headless                     Render offscreen without a window (requires -o)\n\n");
+
+    printf("  --benchmark                Simulate the log as fast as possible without\n");
+    printf("                             drawing and print throughput statistics\n\n");
+
+    printf("  --compile-log FILE         Parse the log once into a compiled log FILE\n");
+    printf("                             that can be replayed without parsing\n\n");
+
+    printf("  --metrics PORT|SOCKET      Serve Prometheus metrics on a localhost port or unix socket\n\n");
+
+    printf("  --trace-file FILE          Record a Chrome trace of each frame to FILE\n");
+    printf("  --trace-seconds SECONDS    Seconds of trace written when pressing 't' (default: 10)\n\n");
 
     printf("FILE should be a log file or '-' to read STDIN.\n\n");
 
@@ -131,12 +163,20 @@ LogstalgiaSettings::LogstalgiaSettings() {
     // arg types
 
     arg_types["font-size"] = "int";
+    arg_types["ball-budget"] = "int";
+    arg_types["reorder-window"] = "int";
+
+    arg_types["output-frames"]   = "int";
+    arg_types["render-segments"] = "int";
 
     arg_types["help"]          = "bool";
     arg_types["extended-help"] = "bool";
     arg_types["splash"]        = "bool";
 
     arg_types["sync"]            = "bool";
+    arg_types["follow"]          = "bool";
+    arg_types["headless"]        = "bool";
+    arg_types["benchmark"]       = "bool";
     arg_types["full-hostnames"]  = "bool";
     arg_types["no-bounce"]       = "bool";
     arg_types["ffp"]             = "bool";
@@ -154,6 +194,9 @@ LogstalgiaSettings::LogstalgiaSettings() {
     arg_types["glow-multiplier"]  = "float";
     arg_types["glow-duration"]    = "float";
     arg_types["paddle-position"]  = "float";
+    arg_types["preroll"]          = "float";
+    arg_types["warmup"]           = "float";
+    arg_types["trace-seconds"]    = "float";
 
     arg_types["pitch-speed"]      = "float";
     arg_types["simulation-speed"] = "float";
@@ -171,6 +214,14 @@ LogstalgiaSettings::LogstalgiaSettings() {
     arg_types["start-position"]     = "string";
     arg_types["stop-position"]      = "string";
     arg_types["paddle-mode"]        = "string";
+    arg_types["log-format"]         = "string";
+    arg_types["json-fields"]        = "string";
+    arg_types["ball-size"]          = "string";
+    arg_types["output-format"]      = "string";
+    arg_types["trace-file"]         = "string";
+    arg_types["metrics"]            = "string";
+    arg_types["listen"]             = "string";
+    arg_types["compile-log"]        = "string";
 }
 
 void LogstalgiaSettings::setLogstalgiaDefaults() {
@@ -178,6 +229,29 @@ void LogstalgiaSettings::setLogstalgiaDefaults() {
     path = "";
 
     sync = false;
+    follow = false;
+
+    headless = false;
+
+    benchmark = false;
+    no_display = false;
+
+    output_format = OUTPUT_FORMAT_PPM;
+    output_frames = 0;
+
+    preroll = 0.0f;
+
+    warmup = 60.0f;
+
+    render_segments = 0;
+
+    trace_file    = "";
+
+    compile_log = "";
+
+    metrics_endpoint = "";
+    listen_endpoint  = "";
+    trace_seconds = 10.0f;
 
     start_time = stop_time = 0;
 
@@ -187,6 +261,11 @@ void LogstalgiaSettings::setLogstalgiaDefaults() {
     paddle_mode     = PADDLE_SINGLE;
     paddle_position = 0.67f;
 
+    log_format  = "";
+    json_fields = "";
+
+    ball_size = BALL_SIZE_BYTES;
+
     pitch_speed       = 0.15f;
     simulation_speed  = 1.0f;
     update_rate       = 5.0f;
@@ -214,9 +293,29 @@ void LogstalgiaSettings::setLogstalgiaDefaults() {
 
     font_size = 14;
 
+    ball_budget = 0;
+
+    reorder_window = 0;
+
     groups.clear();
 }
 
+// accepts a unix timestamp prefixed with '@' in addition to a date time
+bool LogstalgiaSettings::parseTimestamp(const std::string& value, time_t& timestamp) {
+
+    if(value.size() > 1 && value[0] == '@') {
+        char* end = 0;
+        long long seconds = strtoll(value.c_str()+1, &end, 10);
+
+        if(*end != '\0') return false;
+
+        timestamp = (time_t) seconds;
+        return true;
+    }
+
+    return parseDateTime(value, timestamp);
+}
+
 void LogstalgiaSettings::commandLineOption(const std::string& name, const std::string& value) {
 
     if(name == "help") {
@@ -317,6 +416,28 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
         }
     }
 
+    if((entry = settings->getEntry("ball-budget")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify ball budget (number of balls)");
+
+        ball_budget = entry->getInt();
+
+        if(ball_budget < 0) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
+    if((entry = settings->getEntry("reorder-window")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify reorder window (seconds)");
+
+        reorder_window = entry->getInt();
+
+        if(reorder_window < 0) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
     if((entry = settings->getEntry("background")) != 0) {
 
         if(!entry->hasValue()) conffile.entryException(entry, "specify background colour (FFFFFF)");
@@ -339,7 +460,7 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
 
         if(!entry->hasValue()) conffile.entryException(entry, "specify from (YYYY-MM-DD hh:mm:ss)");
 
-        if(!parseDateTime(entry->getString(), start_time)) {
+        if(!parseTimestamp(entry->getString(), start_time)) {
             conffile.invalidValueException(entry);
         }
     }
@@ -348,7 +469,90 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
 
         if(!entry->hasValue()) conffile.entryException(entry, "specify to (YYYY-MM-DD hh:mm:ss)");
 
-        if(!parseDateTime(entry->getString(), stop_time)) {
+        if(!parseTimestamp(entry->getString(), stop_time)) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
+    if((entry = settings->getEntry("preroll")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify preroll (seconds)");
+
+        preroll = entry->getFloat();
+
+        if(preroll < 0.0f) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
+    if((entry = settings->getEntry("warmup")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify warmup (seconds)");
+
+        warmup = entry->getFloat();
+
+        if(warmup < 0.0f) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
+    if((entry = settings->getEntry("output-frames")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify output-frames (frames)");
+
+        output_frames = entry->getInt();
+
+        if(output_frames < 0) {
+            conffile.invalidValueException(entry);
+        }
+    }
+
+    if((entry = settings->getEntry("render-segments")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify render-segments (2 or more)");
+
+        render_segments = entry->getInt();
+
+        if(render_segments < 2 || render_segments > 256) {
+            conffile.entryException(entry, "render-segments should be between 2 and 256");
+        }
+    }
+
+    if((entry = settings->getEntry("trace-file")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify trace-file (file path)");
+
+        trace_file = entry->getString();
+    }
+
+    if((entry = settings->getEntry("compile-log")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify compile-log (file path)");
+
+        compile_log = entry->getString();
+    }
+
+    if((entry = settings->getEntry("metrics")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify metrics (port or unix socket path)");
+
+        metrics_endpoint = entry->getString();
+    }
+
+    if((entry = settings->getEntry("listen")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify listen ([address:]port)");
+
+        listen_endpoint = entry->getString();
+    }
+
+    if((entry = settings->getEntry("trace-seconds")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify trace-seconds (seconds)");
+
+        trace_seconds = entry->getFloat();
+
+        if(trace_seconds <= 0.0f) {
             conffile.invalidValueException(entry);
         }
     }
@@ -387,7 +591,7 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
 
     if((entry = settings->getEntry("paddle-mode")) != 0) {
 
-        if(!entry->hasValue()) conffile.entryException(entry, "specify paddle-mode (vhost,pid)");
+        if(!entry->hasValue()) conffile.entryException(entry, "specify paddle-mode (vhost,pid,upstream)");
 
         std::string paddle_mode_string = entry->getString();
 
@@ -400,11 +604,68 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
         } else if(paddle_mode_string == "vhost") {
             paddle_mode = PADDLE_VHOST;
 
+        } else if(paddle_mode_string == "upstream") {
+            paddle_mode = PADDLE_UPSTREAM;
+
         } else {
             conffile.entryException(entry, "invalid paddle-mode");
         }
     }
 
+    if((entry = settings->getEntry("log-format")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify log-format (format string)");
+
+        log_format = entry->getString();
+    }
+
+    if((entry = settings->getEntry("json-fields")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify json-fields (FIELD=KEY,...)");
+
+        json_fields = entry->getString();
+    }
+
+    if((entry = settings->getEntry("ball-size")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify ball-size (bytes,time)");
+
+        std::string ball_size_string = entry->getString();
+
+        if(ball_size_string == "bytes") {
+            ball_size = BALL_SIZE_BYTES;
+
+        } else if(ball_size_string == "time") {
+            ball_size = BALL_SIZE_TIME;
+
+        } else {
+            conffile.entryException(entry, "invalid ball-size");
+        }
+    }
+
+    if((entry = settings->getEntry("output-format")) != 0) {
+
+        if(!entry->hasValue()) conffile.entryException(entry, "specify output-format (ppm,rgb24,rgba,y4m)");
+
+        std::string output_format_string = entry->getString();
+
+        if(output_format_string == "ppm") {
+            output_format = OUTPUT_FORMAT_PPM;
+
+        } else if(output_format_string == "rgb24") {
+            output_format = OUTPUT_FORMAT_RGB24;
+
+        } else if(output_format_string == "rgba") {
+            output_format = OUTPUT_FORMAT_RGBA;
+
+        } else if(output_format_string == "y4m") {
+            output_format = OUTPUT_FORMAT_Y4M;
+
+        } else {
+            conffile.entryException(entry, "invalid output-format");
+        }
+    }
+
     if((entry = settings->getEntry("paddle-position")) != 0) {
 
         if(!entry->hasValue()) conffile.entryException(entry, "specify paddle-position (0.25 - 0.75)");
@@ -453,6 +714,18 @@ void LogstalgiaSettings::importLogstalgiaSettings(ConfFile& conffile, ConfSectio
         sync = true;
     }
 
+    if(settings->getBool("follow")) {
+        follow = true;
+    }
+
+    if(settings->getBool("headless")) {
+        headless = true;
+    }
+
+    if(settings->getBool("benchmark")) {
+        benchmark = true;
+    }
+
     if(settings->getBool("hide-paddle")) {
         paddle_mode = PADDLE_NONE;
     }
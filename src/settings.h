@@ -26,10 +26,21 @@
 #define PADDLE_SINGLE 1
 #define PADDLE_PID    2
 #define PADDLE_VHOST  3
+#define PADDLE_UPSTREAM 4
+
+#define BALL_SIZE_BYTES 0
+#define BALL_SIZE_TIME  1
+
+#define OUTPUT_FORMAT_PPM   0
+#define OUTPUT_FORMAT_RGB24 1
+#define OUTPUT_FORMAT_RGBA  2
+#define OUTPUT_FORMAT_Y4M   3
 
 class LogstalgiaSettings : public SDLAppSettings {
 protected:
     void commandLineOption(const std::string& name, const std::string& value);
+
+    bool parseTimestamp(const std::string& value, time_t& timestamp);
 public:
     int log_level;
     bool ffp;
@@ -52,10 +63,38 @@ public:
     int   paddle_mode;
     float paddle_position;
 
+    std::string log_format;
+    std::string json_fields;
+
+    int ball_size;
+
     float start_position;
     float stop_position;
 
     bool sync;
+    bool follow;
+    bool headless;
+    bool benchmark;
+
+    //running without a display or GL context (--benchmark, --compile-log),
+    //so no fonts or textures can be created
+    bool no_display;
+
+    int output_format;
+    int output_frames;
+
+    float preroll;
+    float warmup;
+
+    int render_segments;
+
+    std::string trace_file;
+
+    std::string compile_log;
+
+    std::string metrics_endpoint;
+    std::string listen_endpoint;
+    float trace_seconds;
 
     bool hide_response_code;
     bool hide_url_prefix;
@@ -78,6 +117,10 @@ public:
 
     int font_size;
 
+    int ball_budget;
+
+    int reorder_window;
+
     LogstalgiaSettings();
 
     void setLogstalgiaDefaults();
@@ -16,14 +16,17 @@
 */
 
 #include "slider.h"
+#include "settings.h"
 
 // PositionSlider
 
 PositionSlider::PositionSlider(float percent) {
     this->percent = percent;
 
-    font = fontmanager.grab("FreeMonoBold.ttf", 16);
-    font.dropShadow(true);
+    if(!settings.no_display) {
+        font = fontmanager.grab("FreeMonoBold.ttf", 16);
+        font.dropShadow(true);
+    }
 
     slidercol = vec3(1.0, 1.0, 1.0);
 
@@ -0,0 +1,172 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stdinlog.h"
+#include "profiler.h"
+
+#include "core/logger.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+StdinLog::StdinLog() {
+
+    epoll_fd    = -1;
+    wake_fd     = -1;
+    stdin_flags = -1;
+
+#ifdef __linux__
+    //epoll refuses regular files, which never block anyway
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if(epoll_fd >= 0 && wake_fd >= 0) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+
+        event.data.fd = wake_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+        event.data.fd = STDIN_FILENO;
+
+        if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &event) != 0) {
+            close(epoll_fd);
+            epoll_fd = -1;
+        }
+    }
+#endif
+
+#ifndef _WIN32
+    //the reader waits for input itself and then drains it without blocking
+    stdin_flags = fcntl(STDIN_FILENO, F_GETFL);
+    if(stdin_flags != -1) fcntl(STDIN_FILENO, F_SETFL, stdin_flags | O_NONBLOCK);
+#endif
+
+    start(this);
+}
+
+StdinLog::~StdinLog() {
+
+#ifdef _WIN32
+    //a blocking read of the console can't be interrupted
+    stop(false);
+#else
+    stop();
+
+    //STDIN may be shared with the shell
+    if(stdin_flags != -1) fcntl(STDIN_FILENO, F_SETFL, stdin_flags);
+#endif
+
+#ifdef __linux__
+    if(epoll_fd >= 0) close(epoll_fd);
+    if(wake_fd >= 0)  close(wake_fd);
+#endif
+}
+
+void StdinLog::wake() {
+#ifdef __linux__
+    if(wake_fd >= 0) {
+        Uint64 wake = 1;
+        if(write(wake_fd, &wake, sizeof(wake)) < 0) debugLog("could not wake stdin reader");
+    }
+#endif
+}
+
+// waits until STDIN may have input. returns false when stopping
+bool StdinLog::waitReadable(BackgroundLogChannel& channel) {
+
+#ifdef __linux__
+    if(epoll_fd >= 0) {
+        struct epoll_event events[2];
+
+        int ready = epoll_wait(epoll_fd, events, 2, -1);
+
+        return !(ready < 0 && errno != EINTR) && !channel.stopping;
+    }
+#endif
+
+#ifndef _WIN32
+    //wake up periodically to check for shutdown
+    struct pollfd pfd;
+    pfd.fd      = STDIN_FILENO;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    poll(&pfd, 1, 250);
+#endif
+
+    return !channel.stopping;
+}
+
+//on Windows the reader may outlive the log (see ~StdinLog), so only the
+//channel and locals are used
+void StdinLog::readInput(BackgroundLogChannel& channel) {
+
+    std::vector<char> chunk(STDIN_LOG_CHUNK);
+
+    std::vector<ReceivedLine> lines;
+    std::string partial;
+
+    while(!channel.stopping) {
+
+#ifdef _WIN32
+        int bytes = _read(0, &(chunk[0]), STDIN_LOG_CHUNK);
+#else
+        ssize_t bytes = ::read(STDIN_FILENO, &(chunk[0]), STDIN_LOG_CHUNK);
+#endif
+
+        if(bytes < 0) {
+#ifndef _WIN32
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                if(!waitReadable(channel)) break;
+                continue;
+            }
+#endif
+            debugLog("error reading from STDIN: %s", strerror(errno));
+            break;
+        }
+
+        if(bytes == 0) break;
+
+        splitLines(&(chunk[0]), &(chunk[0]) + bytes, profiler_ticks(), partial, lines);
+
+        channel.publish(lines);
+    }
+
+    if(!partial.empty() && !channel.stopping) {
+        lines.push_back(ReceivedLine());
+        lines.back().text.swap(partial);
+        lines.back().received = profiler_ticks();
+
+        channel.publish(lines);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_STDINLOG_H
+#define LOGSTALGIA_STDINLOG_H
+
+#include "backgroundlog.h"
+
+// bytes read from STDIN at a time
+#define STDIN_LOG_CHUNK 262144
+
+// Reads STDIN on a background thread so a stalled writer never blocks a
+// frame. The reader waits for input with epoll (poll on other platforms)
+// and reads it in large chunks.
+
+class StdinLog : public BackgroundLog {
+    int epoll_fd;
+    int wake_fd;
+    int stdin_flags;
+
+    bool waitReadable(BackgroundLogChannel& channel);
+protected:
+    void wake();
+public:
+    StdinLog();
+    ~StdinLog();
+
+    void readInput(BackgroundLogChannel& channel);
+};
+
+#endif
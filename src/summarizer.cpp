@@ -16,6 +16,7 @@
 */
 
 #include "summarizer.h"
+#include "settings.h"
 
 #include <algorithm>
 
@@ -302,7 +303,8 @@ void SummItem::updateUnit(const SummUnit& unit) {
     }
 
     this->displaystr = std::string(buff);
-    this->width = font.getWidth(displaystr);
+    //without a display items are never drawn or hovered over
+    this->width = settings.no_display ? 0 : font.getWidth(displaystr);
 
 }
 
@@ -416,7 +418,8 @@ void Summarizer::setSize(int x, float top_gap, float bottom_gap) {
     // TODO: set 'right' explicitly?
     right = (pos_x > (display.width/2)) ? true : false;
 
-    font_gap = font.getMaxHeight() + 4;
+    //without a display the font isn't loaded, so its size stands in for its height
+    font_gap = (settings.no_display ? settings.font_size : font.getMaxHeight()) + 4;
 
     max_strings = (int) ((display.height-top_gap-bottom_gap)/font_gap);
 
@@ -653,7 +656,9 @@ const std::string& Summarizer::getBestMatchStr(const std::string& str) const {
 
 
 float Summarizer::getMiddlePosY(const std::string& str) const {
-    return getPosY(str) + (font.getMaxHeight()) / 2;
+    float font_height = settings.no_display ? (float) settings.font_size : font.getMaxHeight();
+
+    return getPosY(str) + font_height / 2;
 }
 
 float Summarizer::getPosY(const std::string& str) const {
@@ -0,0 +1,425 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sysloglog.h"
+#include "profiler.h"
+
+#include "core/logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#endif
+
+// skips a space separated field, returning the start of the next
+static const char* syslog_skip_field(const char* p, const char* end) {
+    while(p < end && *p != ' ') p++;
+    if(p < end) p++;
+    return p;
+}
+
+// true if the field starting at p is a tag ('nginx: ', 'nginx[123]: ')
+static bool syslog_is_tag(const char* p, const char* next) {
+    return next - p >= 3 && next[-1] == ' ' && next[-2] == ':';
+}
+
+// <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA MSG
+static const char* syslog_skip_rfc5424_header(const char* p, const char* end) {
+
+    for(int i=0; i<5; i++) {
+        p = syslog_skip_field(p, end);
+    }
+
+    //structured data is '-' or one or more [id param="value" ...] elements
+    if(p < end && *p == '-') {
+        p++;
+    } else {
+        while(p < end && *p == '[') {
+            p++;
+
+            //']' is escaped inside values
+            while(p < end && *p != ']') {
+                if(*p == '\\' && p+1 < end) p++;
+                p++;
+            }
+
+            if(p < end) p++;
+        }
+    }
+
+    if(p < end && *p == ' ') p++;
+
+    //UTF-8 byte order mark
+    if(end - p >= 3 && (unsigned char) p[0] == 0xEF && (unsigned char) p[1] == 0xBB && (unsigned char) p[2] == 0xBF) {
+        p += 3;
+    }
+
+    return p;
+}
+
+// <PRI>Mmm dd hh:mm:ss HOSTNAME TAG: MSG
+static const char* syslog_skip_rfc3164_header(const char* p, const char* end) {
+
+    bool timestamp = end - p >= 16 && p[3] == ' ' && p[6] == ' ' && p[9] == ':' && p[12] == ':' && p[15] == ' ';
+
+    if(timestamp) p += 16;
+
+    const char* next = syslog_skip_field(p, end);
+
+    //nginx omits the hostname with 'nohostname'
+    if(syslog_is_tag(p, next)) return next;
+
+    const char* after = syslog_skip_field(next, end);
+
+    if(syslog_is_tag(next, after)) return after;
+
+    //a hostname without a tag
+    if(timestamp) return next;
+
+    return p;
+}
+
+void SyslogLog::parseMessage(const char* p, const char* end, std::string& message) {
+
+    //trailing line endings and nul terminators
+    while(end > p && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == '\0')) end--;
+
+    if(p < end && *p == '<') {
+
+        const char* q = p + 1;
+        int digits = 0;
+
+        while(q < end && *q >= '0' && *q <= '9' && digits < 3) {
+            q++;
+            digits++;
+        }
+
+        //anything else is passed through as is
+        if(digits > 0 && q < end && *q == '>') {
+            p = q + 1;
+
+            if(end - p >= 2 && *p >= '1' && *p <= '9' && p[1] == ' ') {
+                p = syslog_skip_rfc5424_header(p + 2, end);
+            } else {
+                p = syslog_skip_rfc3164_header(p, end);
+            }
+        }
+    }
+
+    message.assign(p, end - p);
+}
+
+SyslogLog::SyslogLog(const std::string& endpoint) {
+
+    udp_fd = -1;
+    tcp_fd = -1;
+
+#ifdef _WIN32
+    throw SyslogException("listening for syslog messages is not supported on this platform");
+#else
+    std::string address = "127.0.0.1";
+    std::string port_string = endpoint;
+
+    size_t colon = endpoint.rfind(':');
+
+    if(colon != std::string::npos) {
+        address     = endpoint.substr(0, colon);
+        port_string = endpoint.substr(colon+1);
+    }
+
+    int port = atoi(port_string.c_str());
+
+    if(port_string.empty() || port_string.find_first_not_of("0123456789") != std::string::npos || port < 1 || port > 65535) {
+        throw SyslogException("invalid listen port " + port_string);
+    }
+
+    struct sockaddr_in socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port   = htons(port);
+
+    if(inet_pton(AF_INET, address.c_str(), &socket_address.sin_addr) != 1) {
+        throw SyslogException("invalid listen address " + address);
+    }
+
+    udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if(udp_fd < 0 || bind(udp_fd, (struct sockaddr*) &socket_address, sizeof(socket_address)) != 0) {
+        closeSockets();
+        throw SyslogException("could not bind UDP port " + endpoint);
+    }
+
+    //room to absorb bursts between reads
+    int receive_buffer = 4 << 20;
+    setsockopt(udp_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+
+    tcp_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    int reuse = 1;
+    if(tcp_fd >= 0) setsockopt(tcp_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if(tcp_fd < 0 || bind(tcp_fd, (struct sockaddr*) &socket_address, sizeof(socket_address)) != 0 || listen(tcp_fd, 16) != 0) {
+        closeSockets();
+        throw SyslogException("could not bind TCP port " + endpoint);
+    }
+
+    fcntl(udp_fd, F_SETFL, fcntl(udp_fd, F_GETFL) | O_NONBLOCK);
+    fcntl(tcp_fd, F_SETFL, fcntl(tcp_fd, F_GETFL) | O_NONBLOCK);
+
+    datagrams.resize(SYSLOG_LOG_BATCH * SYSLOG_LOG_MESSAGE_SIZE);
+
+    debugLog("listening for syslog messages on %s:%d", address.c_str(), port);
+
+    start(this);
+#endif
+}
+
+SyslogLog::~SyslogLog() {
+    stop();
+    closeSockets();
+}
+
+void SyslogLog::closeSockets() {
+#ifndef _WIN32
+    for(SyslogClient& client : clients) {
+        close(client.fd);
+    }
+    clients.clear();
+
+    if(udp_fd >= 0) close(udp_fd);
+    if(tcp_fd >= 0) close(tcp_fd);
+#endif
+    udp_fd = -1;
+    tcp_fd = -1;
+}
+
+// a message may hold more than one line
+void SyslogLog::addMessage(const char* p, const char* end, Uint64 received, std::vector<ReceivedLine>& lines) {
+
+    while(p < end) {
+
+        const char* eol = (const char*) memchr(p, '\n', end - p);
+        if(eol == 0) eol = end;
+
+        if(eol > p) {
+            lines.push_back(ReceivedLine());
+
+            ReceivedLine& line = lines.back();
+            line.received = received;
+
+            parseMessage(p, eol, line.text);
+
+            if(line.text.empty()) lines.pop_back();
+        }
+
+        p = eol + 1;
+    }
+}
+
+void SyslogLog::receiveDatagrams(std::vector<ReceivedLine>& lines) {
+#ifndef _WIN32
+
+#ifdef __linux__
+    //receive a batch of messages per system call
+    struct mmsghdr messages[SYSLOG_LOG_BATCH];
+    struct iovec   vectors[SYSLOG_LOG_BATCH];
+
+    memset(messages, 0, sizeof(messages));
+
+    for(int i=0; i<SYSLOG_LOG_BATCH; i++) {
+        vectors[i].iov_base = &(datagrams[i * SYSLOG_LOG_MESSAGE_SIZE]);
+        vectors[i].iov_len  = SYSLOG_LOG_MESSAGE_SIZE;
+
+        messages[i].msg_hdr.msg_iov    = &(vectors[i]);
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while(true) {
+        int count = recvmmsg(udp_fd, messages, SYSLOG_LOG_BATCH, MSG_DONTWAIT, 0);
+
+        if(count <= 0) break;
+
+        Uint64 received = profiler_ticks();
+
+        for(int i=0; i<count; i++) {
+            const char* message = &(datagrams[i * SYSLOG_LOG_MESSAGE_SIZE]);
+            addMessage(message, message + messages[i].msg_len, received, lines);
+        }
+
+        if(count < SYSLOG_LOG_BATCH) break;
+    }
+#else
+    while(true) {
+        ssize_t bytes = recv(udp_fd, &(datagrams[0]), SYSLOG_LOG_MESSAGE_SIZE, MSG_DONTWAIT);
+
+        if(bytes <= 0) break;
+
+        addMessage(&(datagrams[0]), &(datagrams[0]) + bytes, profiler_ticks(), lines);
+    }
+#endif
+
+#endif
+}
+
+void SyslogLog::acceptClient() {
+#ifndef _WIN32
+    int fd = accept(tcp_fd, 0, 0);
+
+    if(fd < 0) return;
+
+    if(clients.size() >= SYSLOG_LOG_MAX_CLIENTS) {
+        debugLog("too many syslog connections");
+        close(fd);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    SyslogClient client;
+    client.fd = fd;
+
+    clients.push_back(client);
+#endif
+}
+
+// returns false when the connection has been closed
+bool SyslogLog::receiveStream(SyslogClient& client, std::vector<ReceivedLine>& lines) {
+#ifndef _WIN32
+    char chunk[65536];
+
+    ssize_t bytes = recv(client.fd, chunk, sizeof(chunk), 0);
+
+    if(bytes < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    Uint64 received = profiler_ticks();
+
+    if(bytes == 0) {
+        if(!client.buffer.empty()) {
+            addMessage(client.buffer.data(), client.buffer.data() + client.buffer.size(), received, lines);
+        }
+        return false;
+    }
+
+    client.buffer.append(chunk, bytes);
+
+    const char* start = client.buffer.data();
+    const char* end   = start + client.buffer.size();
+    const char* p     = start;
+
+    while(p < end) {
+
+        //octet counting: 'LENGTH <PRI>MESSAGE'. anything else, including raw
+        //log lines starting with a digit, is newline terminated
+        if(*p >= '0' && *p <= '9') {
+            const char* q = p;
+            size_t length = 0;
+
+            while(q < end && *q >= '0' && *q <= '9' && q - p < 8) {
+                length = length * 10 + (*q - '0');
+                q++;
+            }
+
+            //not enough yet to tell which framing is used
+            if(q == end || (*q == ' ' && q+1 == end)) break;
+
+            if(*q == ' ' && *(q+1) == '<') {
+                q++;
+
+                if((size_t) (end - q) < length) break;
+
+                addMessage(q, q + length, received, lines);
+
+                p = q + length;
+                continue;
+            }
+        }
+
+        //newline terminated
+        const char* eol = (const char*) memchr(p, '\n', end - p);
+
+        if(eol == 0) {
+            //never terminated, take what there is
+            if(end - p > SYSLOG_LOG_MESSAGE_SIZE * 8) {
+                addMessage(p, end, received, lines);
+                p = end;
+            }
+            break;
+        }
+
+        addMessage(p, eol, received, lines);
+
+        p = eol + 1;
+    }
+
+    client.buffer.erase(0, p - start);
+#endif
+    return true;
+}
+
+void SyslogLog::readInput(BackgroundLogChannel& channel) {
+#ifndef _WIN32
+    std::vector<ReceivedLine> lines;
+    std::vector<struct pollfd> fds;
+
+    while(!channel.stopping) {
+
+        fds.resize(2 + clients.size());
+
+        fds[0].fd = udp_fd;
+        fds[1].fd = tcp_fd;
+
+        for(size_t i=0; i<clients.size(); i++) {
+            fds[2+i].fd = clients[i].fd;
+        }
+
+        for(struct pollfd& pfd : fds) {
+            pfd.events  = POLLIN;
+            pfd.revents = 0;
+        }
+
+        //wake up periodically to check for shutdown
+        int ready = poll(&(fds[0]), fds.size(), 250);
+
+        if(ready <= 0) continue;
+
+        if(fds[0].revents & POLLIN) receiveDatagrams(lines);
+
+        for(size_t i=clients.size(); i-- > 0; ) {
+
+            if(!(fds[2+i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            if(!receiveStream(clients[i], lines)) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+
+        if(fds[1].revents & POLLIN) acceptClient();
+
+        channel.publish(lines);
+    }
+#endif
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_SYSLOGLOG_H
+#define LOGSTALGIA_SYSLOGLOG_H
+
+#include "backgroundlog.h"
+
+#include <string>
+#include <vector>
+#include <exception>
+
+// largest syslog message accepted (longer UDP messages are truncated)
+#define SYSLOG_LOG_MESSAGE_SIZE 8192
+
+// UDP messages received per recvmmsg() call
+#define SYSLOG_LOG_BATCH 64
+
+#define SYSLOG_LOG_MAX_CLIENTS 64
+
+class SyslogException : public std::exception {
+protected:
+    std::string message;
+public:
+    SyslogException(const std::string& message) : message(message) {}
+    virtual ~SyslogException() throw () {};
+
+    virtual const char* what() const throw() { return message.c_str(); }
+};
+
+struct SyslogClient {
+    int fd;
+    std::string buffer;
+};
+
+// Receives log lines sent by syslog (eg nginx 'access_log syslog:server=...')
+// over UDP and TCP on the same port. The syslog header of each message,
+// RFC 3164 or RFC 5424, is removed so the log line can be parsed as usual.
+// TCP messages may be newline terminated or octet counted (RFC 6587).
+
+class SyslogLog : public BackgroundLog {
+    int udp_fd;
+    int tcp_fd;
+
+    std::vector<SyslogClient> clients;
+    std::vector<char> datagrams;
+
+    void closeSockets();
+
+    void receiveDatagrams(std::vector<ReceivedLine>& lines);
+    void acceptClient();
+    bool receiveStream(SyslogClient& client, std::vector<ReceivedLine>& lines);
+
+    void addMessage(const char* p, const char* end, Uint64 received, std::vector<ReceivedLine>& lines);
+public:
+    SyslogLog(const std::string& endpoint);
+    ~SyslogLog();
+
+    // the log line contained in a syslog message
+    static void parseMessage(const char* p, const char* end, std::string& message);
+
+    void readInput(BackgroundLogChannel& channel);
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+
+#include "core/logger.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <sys/stat.h>
+
+TraceRecorder tracer;
+
+TraceRecorder::TraceRecorder() {
+    enabled     = false;
+    mutex       = 0;
+    event_index = 0;
+    event_count = 0;
+    origin      = 0;
+    us_per_tick = 0.0;
+    dump_no     = 1;
+}
+
+TraceRecorder::~TraceRecorder() {
+    if(mutex != 0) SDL_DestroyMutex(mutex);
+}
+
+void TraceRecorder::open(const std::string& filename, size_t capacity) {
+
+    this->filename = filename;
+
+    events.resize(capacity);
+    event_index = 0;
+    event_count = 0;
+
+    if(mutex == 0) mutex = SDL_CreateMutex();
+
+    origin      = profiler_ticks();
+    us_per_tick = 1000000.0 / (double) profiler_ticks_per_second();
+
+    enabled = true;
+
+    nameThread("main");
+}
+
+void TraceRecorder::nameThread(const std::string& name) {
+    if(!enabled) return;
+
+    SDL_mutexP(mutex);
+    thread_names[(unsigned long) SDL_ThreadID()] = name;
+    SDL_mutexV(mutex);
+}
+
+void TraceRecorder::record(const char* name, Uint64 start, Uint64 duration) {
+    if(!enabled) return;
+
+    TraceEvent event;
+    event.name     = name;
+    event.thread   = (unsigned long) SDL_ThreadID();
+    event.start    = start;
+    event.duration = duration;
+
+    SDL_mutexP(mutex);
+
+    events[event_index] = event;
+    event_index = (event_index + 1) % events.size();
+
+    if(event_count < events.size()) event_count++;
+
+    SDL_mutexV(mutex);
+}
+
+void TraceRecorder::write(const std::string& path, double seconds) {
+    if(events.empty()) return;
+
+    std::vector<TraceEvent> selected;
+    std::map<unsigned long, std::string> names;
+
+    // copy out under the lock, format without it
+    SDL_mutexP(mutex);
+
+    selected.reserve(event_count);
+
+    size_t first = (event_index + events.size() - event_count) % events.size();
+
+    for(size_t i=0; i<event_count; i++) {
+        selected.push_back(events[(first + i) % events.size()]);
+    }
+
+    names = thread_names;
+
+    SDL_mutexV(mutex);
+
+    if(seconds > 0.0 && !selected.empty()) {
+
+        Uint64 latest = 0;
+
+        for(const TraceEvent& event : selected) {
+            latest = std::max(latest, event.start + event.duration);
+        }
+
+        Uint64 window = (Uint64) (seconds * profiler_ticks_per_second());
+        Uint64 cutoff = latest > window ? latest - window : 0;
+
+        std::vector<TraceEvent> recent;
+
+        for(const TraceEvent& event : selected) {
+            if(event.start >= cutoff) recent.push_back(event);
+        }
+
+        selected.swap(recent);
+    }
+
+    writeEvents(path, selected, names);
+}
+
+void TraceRecorder::writeEvents(const std::string& path, const std::vector<TraceEvent>& selected,
+                                const std::map<unsigned long, std::string>& names) {
+
+    FILE* out = fopen(path.c_str(), "w");
+
+    if(out == 0) {
+        errorLog("could not write trace to '%s'", path.c_str());
+        return;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+
+    for(auto& it : names) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", it.first, it.second.c_str());
+        first = false;
+    }
+
+    for(const TraceEvent& event : selected) {
+
+        double ts  = (event.start >= origin) ? (event.start - origin) * us_per_tick : 0.0;
+        double dur = event.duration * us_per_tick;
+
+        fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",\n", event.name, event.thread, ts, dur);
+        first = false;
+    }
+
+    fprintf(out, "\n]}\n");
+
+    fclose(out);
+}
+
+std::string TraceRecorder::dump(double seconds) {
+
+    // insert a number before the extension (trace.json -> trace-0001.json)
+    std::string stem = filename;
+    std::string ext;
+
+    size_t dot   = filename.rfind('.');
+    size_t slash = filename.find_last_of("/\\");
+
+    if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        stem = filename.substr(0, dot);
+        ext  = filename.substr(dot);
+    }
+
+    char path[1024];
+    struct stat finfo;
+
+    while(dump_no < 10000) {
+        snprintf(path, 1024, "%s-%04d%s", stem.c_str(), dump_no, ext.c_str());
+        if(stat(path, &finfo) != 0) break;
+        dump_no++;
+    }
+
+    write(path, seconds);
+
+    return path;
+}
+
+void TraceRecorder::close() {
+    if(!enabled) return;
+
+    write(filename);
+
+    enabled = false;
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2016 Andrew Caudwell (acaudwell@gmail.com)
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version
+    3 of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGSTALGIA_TRACE_H
+#define LOGSTALGIA_TRACE_H
+
+#include "profiler.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+// number of events kept in the trace ring buffer
+#define TRACE_BUFFER_EVENTS 262144
+
+struct TraceEvent {
+    const char*   name;
+    unsigned long thread;
+    Uint64        start;
+    Uint64        duration;
+};
+
+// Records timed events from any thread into a ring buffer and writes them out
+// in the Chrome Trace Event JSON format (chrome://tracing, ui.perfetto.dev).
+//
+// Event names must remain valid for the life of the recorder (string
+// literals or profiler zone names).
+
+class TraceRecorder {
+    //checked without the mutex by threads recording events
+    std::atomic<bool> enabled;
+
+    SDL_mutex* mutex;
+
+    std::vector<TraceEvent> events;
+    size_t event_index;
+    size_t event_count;
+
+    std::map<unsigned long, std::string> thread_names;
+
+    Uint64 origin;
+    double us_per_tick;
+
+    std::string filename;
+    int dump_no;
+
+    void writeEvents(const std::string& path, const std::vector<TraceEvent>& selected,
+                     const std::map<unsigned long, std::string>& names);
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    bool isEnabled() const { return enabled; };
+
+    void open(const std::string& filename, size_t capacity = TRACE_BUFFER_EVENTS);
+
+    void nameThread(const std::string& name);
+
+    void record(const char* name, Uint64 start, Uint64 duration);
+
+    // write events from the last 'seconds' (or all events if 0)
+    void write(const std::string& path, double seconds = 0.0);
+
+    // write recent events to the next free numbered trace file
+    std::string dump(double seconds);
+
+    // write all buffered events to the trace file and stop recording
+    void close();
+};
+
+extern TraceRecorder tracer;
+
+// times a scope on any thread into the trace only (not the frame profiler)
+
+class TraceScope {
+    const char* name;
+    Uint64 start_ticks;
+public:
+    TraceScope(const char* name) : name(0) {
+        if(tracer.isEnabled()) {
+            this->name  = name;
+            start_ticks = profiler_ticks();
+        }
+    }
+
+    ~TraceScope() {
+        if(name != 0) tracer.record(name, start_ticks, profiler_ticks() - start_ticks);
+    }
+};
+
+#endif